@@ -0,0 +1,93 @@
+#include "Accumulator.h"
+#include <string>
+
+void ExactSum::Add(double x, uint64_t times) {
+  if (x <= 0.0 || times == 0)
+    return;
+  // x = mantissa * 2^exponent with an integer mantissa of 53 bits
+  int exponent;
+  double fraction = frexp(x, &exponent);
+  uint64_t mantissa = (uint64_t)ldexp(fraction, 53);
+  exponent -= 53;
+  if (exponent < -1074) { // subnormal: the low bits of mantissa are zero
+    mantissa >>= -1074 - exponent;
+    exponent = -1074;
+  }
+  int bit = exponent + 1074;
+  // up to 117 bits, added in two halves so that the shifts cannot overflow
+  unsigned __int128 product = (unsigned __int128)mantissa * times;
+  AddAt(bit / 64, (unsigned __int128)(uint64_t)product << (bit % 64));
+  AddAt(bit / 64 + 1, (product >> 64) << (bit % 64));
+}
+
+void ExactSum::Add(const ExactSum &other) {
+  for (int i = 0; i < NUM_LIMBS; i++) {
+    AddAt(i, other.limbs_[i]);
+  }
+}
+
+void ExactSum::AddAt(int limb, unsigned __int128 value) {
+  for (int i = limb; value != 0 && i < NUM_LIMBS; i++) {
+    value += limbs_[i];
+    limbs_[i] = (uint64_t)value;
+    value >>= 64;
+  }
+}
+
+long double ExactSum::Value() const {
+  // low limbs first, they can only affect the rounding
+  long double value = 0.0;
+  for (int i = 0; i < NUM_LIMBS; i++) {
+    if (limbs_[i] != 0)
+      value += ldexpl((long double)limbs_[i], 64 * i - 1074);
+  }
+  return value;
+}
+
+void ExactSum::Write(ostream &out) const {
+  ios::fmtflags flags = out.flags();
+  out << hex;
+  for (int i = NUM_LIMBS - 1; i >= 0; i--) {
+    out << limbs_[i] << (i > 0 ? " " : "");
+  }
+  out.flags(flags);
+}
+
+bool ExactSum::Read(istream &in) {
+  ios::fmtflags flags = in.flags();
+  in >> hex;
+  for (int i = NUM_LIMBS - 1; i >= 0; i--) {
+    in >> limbs_[i];
+  }
+  in.flags(flags);
+  return !in.fail();
+}
+
+double Accumulator::Variance() const {
+  if (count_ < 2)
+    return 0.0;
+  long double sum = sum_.Value();
+  long double squares = sum_squares_.Value();
+  long double variance = (squares - sum * sum / count_) / (count_ - 1);
+  return variance > 0.0 ? (double)variance : 0.0;
+}
+
+void Accumulator::Write(ostream &out) const {
+  out << "count " << count_ << endl << "sum ";
+  sum_.Write(out);
+  out << endl << "sum_squares ";
+  sum_squares_.Write(out);
+  out << endl;
+}
+
+bool Accumulator::Read(istream &in) {
+  string name;
+  in >> name >> count_;
+  if (name != "count")
+    return false;
+  in >> name;
+  if (name != "sum" || !sum_.Read(in))
+    return false;
+  in >> name;
+  return name == "sum_squares" && sum_squares_.Read(in);
+}
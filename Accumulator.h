@@ -0,0 +1,93 @@
+#ifndef ACCUMULATOR_H
+#define ACCUMULATOR_H
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+using namespace std;
+
+// Normal quantile for a two-sided 95% confidence interval.
+const double Z_95 = 1.959963984540054;
+
+// Exact sum of non-negative doubles, as a fixed-point number spanning the
+// whole double range (from the smallest subnormal up, with room for 2^64
+// of the largest values). Adding is integer arithmetic, so the sum does not
+// depend on the order of the terms nor on how they were grouped.
+class ExactSum {
+public:
+  ExactSum() { limbs_.fill(0); }
+
+  // x must be finite and non-negative.
+  void Add(double x) { Add(x, 1); }
+
+  // Adds x times times, exactly as that many Add(x).
+  void Add(double x, uint64_t times);
+
+  void Add(const ExactSum &other);
+
+  // The sum, correctly rounded or nearly so. Always the same for the same
+  // exact sum.
+  long double Value() const;
+
+  // Hexadecimal limbs, most significant first.
+  void Write(ostream &out) const;
+  bool Read(istream &in);
+
+private:
+  // Bit 0 of limb 0 weighs 2^-1074.
+  static const int NUM_LIMBS = 34;
+  array<uint64_t, NUM_LIMBS> limbs_;
+
+  // Adds value * 2^(64 * limb).
+  void AddAt(int limb, unsigned __int128 value);
+};
+
+// Running mean and variance of the per-sample estimates. Sums are exact,
+// so accumulators over disjoint samples merge into exactly the statistics
+// of a single accumulator over all of them, in any order.
+class Accumulator {
+public:
+  void Add(double x) {
+    count_++;
+    sum_.Add(x);
+    sum_squares_.Add(x * x);
+  }
+
+  // Adds times values of x, exactly as that many Add(x).
+  void Add(double x, long times) {
+    count_ += times;
+    sum_.Add(x, times);
+    sum_squares_.Add(x * x, times);
+  }
+
+  void Merge(const Accumulator &other) {
+    count_ += other.count_;
+    sum_.Add(other.sum_);
+    sum_squares_.Add(other.sum_squares_);
+  }
+
+  long Count() const { return count_; }
+
+  double Mean() const { return count_ > 0 ? sum_.Value() / count_ : 0.0; }
+
+  // Unbiased sample variance.
+  double Variance() const;
+
+  // Half width of the normal confidence interval of the mean.
+  double HalfWidth(double z = Z_95) const {
+    return count_ > 0 ? z * sqrt(Variance() / count_) : INFINITY;
+  }
+
+  // Saves the count and both sums, Read restores them exactly.
+  void Write(ostream &out) const;
+  bool Read(istream &in);
+
+private:
+  long count_ = 0;
+  ExactSum sum_;
+  ExactSum sum_squares_;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "Accumulator.h"
+#include "gtest/gtest.h"
+#include <sstream>
+
+namespace {
+TEST(AccumulatorTest, MeanAndVarianceTest) {
+  Accumulator acc;
+  acc.Add(1.0);
+  acc.Add(2.0);
+  acc.Add(4.0);
+
+  EXPECT_EQ(acc.Count(), 3);
+  EXPECT_DOUBLE_EQ(acc.Mean(), 7.0 / 3.0);
+  // squared differences from the mean: 16/9 + 1/9 + 25/9
+  EXPECT_DOUBLE_EQ(acc.Variance(), 42.0 / 9.0 / 2.0);
+  EXPECT_DOUBLE_EQ(acc.HalfWidth(2.0), 2.0 * sqrt(acc.Variance() / 3.0));
+}
+
+TEST(AccumulatorTest, MergeTest) {
+  Accumulator all, first, second;
+  for (int i = 0; i < 10; i++) {
+    double x = i * i * 0.1;
+    all.Add(x);
+    (i < 4 ? first : second).Add(x);
+  }
+  first.Merge(second);
+
+  // the sums are exact: merging gives exactly the same statistics
+  EXPECT_EQ(first.Count(), all.Count());
+  EXPECT_EQ(first.Mean(), all.Mean());
+  EXPECT_EQ(first.Variance(), all.Variance());
+}
+
+TEST(AccumulatorTest, AddTimesTest) {
+  Accumulator repeated, times;
+  for (int i = 0; i < 1000; i++) {
+    repeated.Add(0.1);
+  }
+  repeated.Add(1e300);
+  times.Add(0.1, 1000L);
+  times.Add(1e300, 1L);
+  times.Add(0.5, 0L);
+  std::stringstream a, b;
+  repeated.Write(a);
+  times.Write(b);
+  EXPECT_EQ(a.str(), b.str());
+}
+
+TEST(AccumulatorTest, ExactSumTest) {
+  // 1 + 1e-30 - 1 cannot be done in doubles, any order loses something
+  ExactSum sum;
+  sum.Add(1e-30);
+  sum.Add(1.0);
+  sum.Add(4.9e-324); // smallest subnormal
+  sum.Add(1e300);
+  ExactSum reordered;
+  reordered.Add(1e300);
+  reordered.Add(4.9e-324);
+  reordered.Add(1.0);
+  reordered.Add(1e-30);
+  std::stringstream a, b;
+  sum.Write(a);
+  reordered.Write(b);
+  EXPECT_EQ(a.str(), b.str());
+  EXPECT_EQ(sum.Value(), reordered.Value());
+}
+
+TEST(AccumulatorTest, WriteReadTest) {
+  Accumulator acc;
+  for (int i = 0; i < 100; i++) {
+    acc.Add(1.0 / (i + 3));
+  }
+  std::stringstream stream;
+  acc.Write(stream);
+  Accumulator copy;
+  EXPECT_TRUE(copy.Read(stream));
+  EXPECT_EQ(copy.Count(), acc.Count());
+  EXPECT_EQ(copy.Mean(), acc.Mean());
+  EXPECT_EQ(copy.Variance(), acc.Variance());
+}
+} // namespace
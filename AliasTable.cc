@@ -0,0 +1,43 @@
+#include "AliasTable.h"
+
+AliasTable::AliasTable(const vector<double> &weights)
+    : prob_(weights.size(), 1.0), alias_(weights.size()) {
+  for (double weight : weights) {
+    total_ += weight;
+  }
+  if (total_ <= 0.0)
+    return;
+
+  // scale so that the average slot holds exactly 1, then let every slot
+  // below 1 be topped up by one above 1
+  int n = weights.size();
+  vector<double> scaled(n);
+  vector<int> small, large;
+  for (int i = 0; i < n; i++) {
+    alias_[i] = i;
+    scaled[i] = weights[i] * n / total_;
+    if (scaled[i] < 1.0)
+      small.push_back(i);
+    else
+      large.push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    int less = small.back();
+    small.pop_back();
+    int more = large.back();
+    prob_[less] = scaled[less];
+    alias_[less] = more;
+    scaled[more] -= 1.0 - scaled[less];
+    if (scaled[more] < 1.0) {
+      large.pop_back();
+      small.push_back(more);
+    }
+  }
+  // whatever is left is 1 up to rounding errors, prob_ is already 1
+}
+
+int AliasTable::Sample(double u) const {
+  double slot = u * prob_.size();
+  int i = (int)slot;
+  return slot - i < prob_[i] ? i : alias_[i];
+}
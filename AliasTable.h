@@ -0,0 +1,28 @@
+#ifndef ALIAS_TABLE_H
+#define ALIAS_TABLE_H
+
+#include <vector>
+
+using namespace std;
+
+// Walker's alias table: draws an index with probability proportional to
+// its weight in constant time, after a linear time construction.
+class AliasTable {
+public:
+  AliasTable() = default;
+  AliasTable(const vector<double> &weights);
+
+  // Returns index i with probability weights[i] / Total(), u being uniform
+  // in [0, 1). Total() must be positive.
+  int Sample(double u) const;
+
+  double Total() const { return total_; }
+
+private:
+  double total_ = 0.0;
+  // Slot i returns i with probability prob_[i], else alias_[i].
+  vector<double> prob_;
+  vector<int> alias_;
+};
+
+#endif
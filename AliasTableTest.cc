@@ -0,0 +1,25 @@
+#include "AliasTable.h"
+#include "gtest/gtest.h"
+
+namespace {
+TEST(AliasTableTest, ExactProbabilitiesTest) {
+  vector<double> weights = {1.0, 0.0, 3.0, 4.0};
+  AliasTable table(weights);
+  EXPECT_DOUBLE_EQ(table.Total(), 8.0);
+
+  // sweep u over a fine grid: each index must get its share of it
+  const int steps = 80000;
+  vector<int> counts(weights.size(), 0);
+  for (int i = 0; i < steps; i++) {
+    counts[table.Sample((i + 0.5) / steps)]++;
+  }
+  for (size_t i = 0; i < weights.size(); i++) {
+    EXPECT_NEAR(counts[i], steps * weights[i] / 8.0, 1.0);
+  }
+}
+
+TEST(AliasTableTest, EmptyTest) {
+  AliasTable table(vector<double>(3, 0.0));
+  EXPECT_EQ(table.Total(), 0.0);
+}
+} // namespace
@@ -0,0 +1,33 @@
+#include "BitParallelSolver.h"
+
+BitParallelSolver::BitParallelSolver(Graph &graph, int num_samples,
+                                     uint64_t seed)
+    : Solver(graph),
+      num_samples_((num_samples + NUM_LANES - 1) / NUM_LANES * NUM_LANES),
+      seed_(seed) {
+  sources_.push_back(source_._Find_first());
+  sink_node_ = target_._Find_first();
+  OutArcs out_arcs(NUM_NODES);
+  FOREACH_BS(edge_id, all_edges_) {
+    EdgeInfo &info = edge_info_[edge_id];
+    out_arcs[info.edge_terminals.first].emplace_back(
+        thresholds_.size(), info.edge_terminals.second);
+    thresholds_.push_back(ProbabilityThreshold(info.p));
+  }
+  arc_lanes_.resize(thresholds_.size());
+  bfs_ = LaneBfs(out_arcs);
+}
+
+double BitParallelSolver::Solve() {
+  long long reaching = 0;
+  for (int batch = 0; batch < num_samples_ / NUM_LANES; batch++) {
+    rng_ = Philox(seed_, batch);
+    for (size_t i = 0; i < thresholds_.size(); i++) {
+      arc_lanes_[i] = SampleLanes(rng_, thresholds_[i]);
+    }
+    const vector<Lanes> &reached =
+        bfs_.Reach(arc_lanes_.data(), sources_, sink_node_);
+    reaching += __builtin_popcountll(reached[sink_node_]);
+  }
+  return double(reaching) / double(num_samples_);
+}
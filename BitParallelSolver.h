@@ -0,0 +1,44 @@
+#ifndef BIT_PARALLEL_SOLVER_H
+#define BIT_PARALLEL_SOLVER_H
+
+#include "Graph.h"
+#include "LaneBfs.h"
+#include "Philox.h"
+#include "Sample.h"
+#include "Solver.h"
+#include "Util.h"
+#include <cstdint>
+#include <vector>
+
+// Pure Monte Carlo estimate of the reachability probability. Samples
+// NUM_LANES possible worlds at a time, one world per bit lane, and runs a
+// single word-parallel BFS from SOURCE to count the worlds reaching SINK.
+class BitParallelSolver : public Solver {
+public:
+  BitParallelSolver(Graph &graph, int num_samples, uint64_t seed);
+
+  double Solve();
+
+private:
+  // Number of worlds to sample, rounded up to a multiple of NUM_LANES.
+  int num_samples_;
+
+  // Probability of each arc scaled to 32 bits, see ProbabilityThreshold.
+  vector<uint64_t> thresholds_;
+
+  vector<int> sources_;
+  int sink_node_;
+
+  uint64_t seed_;
+
+  // Random stream of the current batch.
+  Philox rng_;
+
+  // Presence of each arc (index in thresholds_) in the current NUM_LANES
+  // worlds.
+  vector<Lanes> arc_lanes_;
+
+  LaneBfs bfs_;
+};
+
+#endif
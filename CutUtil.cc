@@ -0,0 +1,208 @@
+#include "CutUtil.h"
+
+Cut CutUtil::CreateFirstCut() {
+  Nodes left;
+  Nodes middle;
+  // initially all nodes are on the right
+  Nodes right = nodes_;
+  Edges covered;
+  // move source from right to left
+  left.set(source_);
+  right.reset(source_);
+  // move nodes adjacent to source from right to middle
+  // and mark covered edges in the process
+  for (auto &arc : out_arcs_[source_]) {
+    int endId = arc.second;
+    if (endId == sink_) {
+      return Cut();
+    }
+    covered.set(arc.first);
+    middle.set(endId);
+    right.reset(endId);
+  }
+  // mark as covered: the edges from the middle not going to the right
+  FOREACH_BS(nodeId, middle) {
+    for (auto &arc : out_arcs_[nodeId]) {
+      if (!right[arc.second]) {
+        covered.set(arc.first);
+      }
+    }
+  }
+
+  // create the cut and recurse
+  return Cut(left, middle, right, covered);
+}
+
+void CutUtil::RemoveRedundantCuts() {
+  for (size_t i = 0; i < cuts_.size(); i++) {
+    Cut currenti = cuts_.at(i);
+    for (size_t j = i + 1; j < cuts_.size(); j++) {
+      Cut currentj = cuts_.at(j);
+      // see if one of them is contained in the other
+      if (currenti.Overlaps(currentj)) {
+        cuts_.erase(cuts_.begin() + i);
+        i--;
+        break;
+      }
+      if (currentj.Overlaps(currenti)) {
+        cuts_.erase(cuts_.begin() + j);
+        j--;
+      }
+    }
+  }
+}
+
+void CutUtil::RefineCuts() {
+  // check for non-minimality: containment of cuts in other cuts
+  RemoveRedundantCuts();
+
+  // grow each cut (if necessary) into a good cut
+  vector<Cut> goodCuts;
+  for (auto &cut : cuts_) {
+    Nodes right = cut.getRight();
+    Nodes middle = cut.getMiddle();
+    Edges covered = cut.getCoveredEdges();
+    // repeat until nothing changes
+    while (true) {
+      // for each node on the right, make sure its outgoing neighbors are all
+      // on the right also
+      vector<int> toAdd;
+      FOREACH_BS(nodeId, right) {
+        for (auto &arc : out_arcs_[nodeId]) {
+          // back edge, grow cut with this node
+          if (!right[arc.second]) {
+            toAdd.push_back(nodeId);
+            break;
+          }
+        }
+      }
+      if (toAdd.size() == 0)
+        break;
+      for (auto nodeId : toAdd) {
+        right.reset(nodeId);
+        middle.set(nodeId);
+      }
+    }
+    // Now some new edges can be covered due to moving nodes to the middle
+    // mark these edges as covered
+    FOREACH_BS(nodeId, middle) {
+      for (auto &arc : out_arcs_[nodeId]) {
+        if (!right[arc.second]) {
+          covered.set(arc.first);
+        }
+      }
+    }
+    // add the new good cut
+    goodCuts.push_back(Cut(cut.getLeft(), middle, right, covered));
+  }
+  cuts_ = goodCuts;
+
+  // Minimize good cuts:
+  // If a node in the middle group has no outgoing edges to the right group
+  // Then move it to the left group
+  vector<Cut> bestCuts;
+  for (auto &cut : cuts_) {
+    Nodes middle = cut.getMiddle();
+    Nodes left = cut.getLeft();
+    Nodes right = cut.getRight();
+    vector<int> toMove;
+    FOREACH_BS(nodeId, middle) {
+      // make sure it has at least one edge to the right
+      bool hasRight = false;
+      for (auto &arc : out_arcs_[nodeId]) {
+        if (right[arc.second]) {
+          hasRight = true;
+          break;
+        }
+      }
+      if (!hasRight) {
+        toMove.push_back(nodeId);
+      }
+    }
+    for (auto nodeId : toMove) {
+      middle.reset(nodeId);
+      left.set(nodeId);
+    }
+    bestCuts.push_back(Cut(left, middle, right, cut.getCoveredEdges()));
+  }
+  cuts_ = bestCuts;
+
+  // Last: remove redundant cuts again
+  RemoveRedundantCuts();
+}
+
+vector<Cut> CutUtil::FindSomeGoodCuts() {
+  // start by forming the first cut: adjacent to source
+  Cut firstCut = CreateFirstCut();
+  if (firstCut.getMiddle().none()) {
+    // That was a dummy returned cut, i.e. no cuts available.
+    return {firstCut};
+  }
+
+  Nodes currentMiddle = firstCut.getMiddle();
+  Nodes currentLeft = firstCut.getLeft();
+  Nodes currentRight = firstCut.getRight();
+  Edges currentCovered = firstCut.getCoveredEdges();
+
+  cuts_.push_back(firstCut);
+  bool added = true;
+  while (added) { // repeat until nothing new is added
+    Nodes middle = currentMiddle;
+    Nodes left = currentLeft;
+    Nodes right = currentRight;
+    Edges covered = currentCovered;
+    added = false;
+    FOREACH_BS(nodeId, currentMiddle) {
+      vector<int> nextNodes;
+      vector<int> nextArcs;
+      for (auto &arc : out_arcs_[nodeId]) {
+        int nextId = arc.second;
+        if (nextId == sink_) { // node connected to target, ignore all
+                               // of its neighbors
+          nextNodes.clear();
+          nextArcs.clear();
+          break;
+        } else if (right[nextId]) { // eligible for moving from right to
+                                    // middle
+          nextNodes.push_back(nextId);
+          nextArcs.push_back(arc.first);
+        }
+      }
+      if (nextNodes.size() > 0) { // There are nodes to move from right to left
+        added = true;
+        for (auto nextId : nextNodes) {
+          right.reset(nextId);
+          middle.set(nextId);
+        }
+        for (auto nextId : nextArcs) {
+          covered.set(nextId);
+        }
+        // node moves to the left: all of its out-arcs are covered now,
+        // including the ones to nodes another middle node just moved
+        for (auto &arc : out_arcs_[nodeId]) {
+          covered.set(arc.first);
+        }
+        middle.reset(nodeId);
+        left.set(nodeId);
+      }
+    }
+    if (added) {
+      // mark as covered: all edges going from the middle not to the right
+      FOREACH_BS(nodeId, middle) {
+        for (auto &arc : out_arcs_[nodeId]) {
+          if (!right[arc.second]) {
+            covered.set(arc.first);
+          }
+        }
+      }
+      Cut newCut(left, middle, right, covered);
+      cuts_.push_back(newCut);
+      currentMiddle = middle;
+      currentLeft = left;
+      currentRight = right;
+      currentCovered = covered;
+    }
+  }
+  RefineCuts();
+  return cuts_;
+}
@@ -4,8 +4,39 @@
 #include "Cut.h"
 #include "Util.h"
 #include <iostream>
+#include <vector>
 
+// Out-arcs of every node as (arc id, target node id) pairs, indexed by node
+// id. This is all that cut discovery needs to know about a graph.
+typedef vector<vector<pair<int, int>>> OutArcs;
+
+// Finds good cuts on any graph representation that can list its nodes and
+// out-arcs by id (Graph and GraphView).
 class CutUtil {
+public:
+  CutUtil(Nodes &nodes, OutArcs &out_arcs, int source, int sink)
+      : nodes_(nodes), out_arcs_(out_arcs), source_(source), sink_(sink) {}
+
+  // Finds *SOME* good cuts: steps from a cut to the next by
+  // replacing every node by all of its neighbors.
+  vector<Cut> FindSomeGoodCuts();
+
+private:
+  Nodes &nodes_;
+  OutArcs &out_arcs_;
+  int source_;
+  int sink_;
+
+  vector<Cut> cuts_;
+
+  // creates first level cut: nodes adjacent to source*/
+  Cut CreateFirstCut();
+
+  // Minimizes the cuts, then makes sure they are "Good"*/
+  void RefineCuts();
+
+  // removes cuts that are masked by smaller cuts*/
+  void RemoveRedundantCuts();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,7 @@
 #define EDGE_SUBSET_H
 
 #include "Cut.h"
+#include "CutUtil.h"
 #include "Util.h"
 #include <unordered_map>
 
@@ -13,21 +14,27 @@
 class EdgeSubset {
 public:
   EdgeSubset() = default;
-  EdgeSubset(int id, Cut &cut, unordered_map<int, EdgeInfo> &edge_info) : id_(id) {
+  // Only the out-arcs of the left nodes are looked at.
+  EdgeSubset(int id, Cut &cut, OutArcs &out_arcs,
+             unordered_map<int, EdgeInfo> &edge_info)
+      : id_(id) {
     Nodes &left = cut.getLeft();
     Nodes &middle = cut.getMiddle();
-    for (auto &info : edge_info) {
-      if (left.test(info.second.edge_terminals.first) &&
-          middle.test(info.second.edge_terminals.second)) {
-        edges_.set(info.first);
-        success_prob_ *= (1.0 - info.second.p);
+    FOREACH_BS(node_id, left) {
+      for (auto &arc : out_arcs[node_id]) {
+        if (middle.test(arc.second)) {
+          edges_.set(arc.first);
+          success_prob_ *= (1.0 - edge_info[arc.first].p);
+        }
       }
     }
     success_prob_ += 0.001;
     cut_size_ = middle.count();
   }
 
-  double Weight() { return success_prob_ * cut_size_ / edges_.count(); }
+  double Weight() {
+    return edges_.any() ? success_prob_ * cut_size_ / edges_.count() : 0.0;
+  }
 
   int Id() {return id_;}
 
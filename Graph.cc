@@ -1,4 +1,9 @@
 #include "Graph.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
 #include <unordered_set>
 
 void Graph::CopyFrom(const Graph &graph) {
@@ -10,10 +15,18 @@ void Graph::CopyFrom(const Graph &graph) {
     name_to_node_[nodes_[node]] = node;
   }
   for (ListDigraph::ArcIt arc(g_); arc != INVALID; ++arc) {
-    edges_.insert(nodes_[g_.source(arc)] + nodes_[g_.target(arc)]);
+    edges_.insert(nodes_[g_.source(arc)] + " " + nodes_[g_.target(arc)]);
   }
 }
 
+Nodes Graph::NodesAsBitset() {
+  Nodes nodes;
+  for (ListDigraph::NodeIt node(g_); node != INVALID; ++node) {
+    nodes.set(g_.id(node));
+  }
+  return nodes;
+}
+
 Edges Graph::EdgesAsBitset() {
   Edges edges;
   for (ListDigraph::ArcIt arc(g_); arc != INVALID; ++arc) {
@@ -48,32 +61,15 @@ void Graph::Print() {
   }
 }
 
-void Graph::AddEdge(string source, string target, double weight) {
-  if (edges_.insert(source + target).second) {
+void Graph::AddEdge(const string &source, const string &target,
+                    double weight) {
+  // names hold no whitespace, so the key is unambiguous
+  if (edges_.insert(source + " " + target).second) {
     ListDigraph::Arc arc = g_.addArc(GetNode(source), GetNode(target));
     weights_[arc] = weight;
   }
 }
 
-void Graph::UpdateWeights(unordered_map<int, double> edge_weights) {
-  for (ListDigraph::ArcIt arc(g_); arc != INVALID; ++arc) {
-    string node_source = nodes_[g_.source(arc)];
-    string node_target = nodes_[g_.target(arc)];
-    if (node_source == SOURCE || node_target == SINK)
-      continue;
-    int edge_id = g_.id(arc);
-    auto prob = edge_weights.find(edge_id);
-    if (prob != edge_weights.end()) {
-      if (prob->second > weights_[arc])
-        weights_[arc] = 1.0;
-      else {
-        weights_[arc] = 0.0;
-        g_.erase(arc);
-      }
-    }
-  }
-}
-
 void Graph::Reverse() {
   // Collect a list of all edges
   vector<ListDigraph::Arc> arcs;
@@ -85,7 +81,7 @@ void Graph::Reverse() {
   }
 }
 
-ListDigraph::Node Graph::GetNode(string name) {
+ListDigraph::Node Graph::GetNode(const string &name) {
   auto node = name_to_node_.find(name);
   if (node != name_to_node_.end()) {
     return node->second;
@@ -106,20 +102,46 @@ void Graph::ReadList(string file_name, vector<string> &list) {
   in.close();
 }
 
-void Graph::Create(string &file_name) {
-  ifstream in(file_name);
-  while (!in.eof()) {
-    string start;
-    string stop;
-    double weight = -1.0;
-    in >> start >> stop >> weight;
-
-    if (weight == -1.0)
-      continue;
+vector<string> Graph::SplitNames(const string &list) {
+  vector<string> names;
+  stringstream in(list);
+  string name;
+  while (getline(in, name, ',')) {
+    if (!name.empty())
+      names.push_back(name);
+  }
+  return names;
+}
 
-    AddEdge(start, stop, weight);
+void Graph::Create(string &file_name) {
+  // The whole file is read at once and split in place, much faster than
+  // extracting from the stream, which matters for many small networks.
+  ifstream in(file_name, ios::binary);
+  string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  edges_.reserve(count(text.begin(), text.end(), '\n') + 1);
+  const char *next = text.c_str();
+  auto token = [&next]() {
+    while (*next == ' ' || *next == '\t' || *next == '\r')
+      next++;
+    const char *begin = next;
+    while (*next && !isspace((unsigned char)*next))
+      next++;
+    return string(begin, next);
+  };
+  // one edge per line: start stop weight, other lines are skipped
+  while (*next) {
+    string start = token();
+    string stop = token();
+    string weight = token();
+    char *end;
+    double p = strtod(weight.c_str(), &end);
+    if (!stop.empty() && !weight.empty() && *end == '\0')
+      AddEdge(start, stop, p);
+    while (*next && *next != '\n')
+      next++;
+    if (*next)
+      next++;
   }
-  in.close();
 }
 
 void Graph::Minimize() {
@@ -129,12 +151,135 @@ void Graph::Minimize() {
   RemoveSelfCycles();
 }
 
+void Graph::CopyFrom(const Graph &graph, const vector<string> &sources,
+                     const vector<string> &targets) {
+  const ListDigraph &g = graph.g_;
+  vector<bool> to_targets(g.maxNodeId() + 1, false);
+  vector<bool> from_sources(g.maxNodeId() + 1, false);
+  vector<ListDigraph::Node> stack;
+  auto visit = [&](ListDigraph::Node node, vector<bool> &reached) {
+    if (!reached[g.id(node)]) {
+      reached[g.id(node)] = true;
+      stack.push_back(node);
+    }
+  };
+  auto find = [&](const string &name) {
+    auto node = graph.name_to_node_.find(name);
+    return node == graph.name_to_node_.end() ? INVALID : node->second;
+  };
+
+  // First the nodes reaching a target, against the edges
+  for (auto &name : targets) {
+    if (find(name) != INVALID)
+      visit(find(name), to_targets);
+  }
+  while (!stack.empty()) {
+    ListDigraph::Node node = stack.back();
+    stack.pop_back();
+    for (ListDigraph::InArcIt arc(g, node); arc != INVALID; ++arc)
+      visit(g.source(arc), to_targets);
+  }
+
+  // Then the ones among them reachable from a source, copying the edges
+  // on the way
+  for (auto &name : sources) {
+    if (find(name) != INVALID && to_targets[g.id(find(name))])
+      visit(find(name), from_sources);
+  }
+  while (!stack.empty()) {
+    ListDigraph::Node node = stack.back();
+    stack.pop_back();
+    for (ListDigraph::OutArcIt arc(g, node); arc != INVALID; ++arc) {
+      ListDigraph::Node target = g.target(arc);
+      if (to_targets[g.id(target)]) {
+        AddEdge(graph.nodes_[node], graph.nodes_[target], graph.weights_[arc]);
+        visit(target, from_sources);
+      }
+    }
+  }
+}
+
 void Graph::Preprocess(string sources_file, string targets_file, string pre) {
-  UnifyTerminals(sources_file, targets_file);
+  vector<string> sources;
+  vector<string> targets;
+
+  // read sources and targets
+  ReadList(sources_file, sources);
+  ReadList(targets_file, targets);
+  Preprocess(sources, targets, pre);
+}
+
+void Graph::Preprocess(const vector<string> &sources,
+                       const vector<string> &targets, string pre) {
+  UnifyTerminals(sources, targets);
   if (pre == PRE_YES) {
     Minimize();
   }
-  // EXTRA STEP: make sure source and sink are not directly connected
+  IsolateTerminals();
+}
+
+double Graph::Sparsify(double max_error) {
+  vector<double> from_source = ReachBounds(true);
+  vector<double> to_sink = ReachBounds(false);
+  vector<pair<double, ListDigraph::Arc>> impacts;
+  for (ListDigraph::ArcIt arc(g_); arc != INVALID; ++arc) {
+    double impact = weights_[arc] * min(from_source[g_.id(g_.source(arc))],
+                                        to_sink[g_.id(g_.target(arc))]);
+    impacts.emplace_back(impact, arc);
+  }
+  sort(impacts.begin(), impacts.end(),
+       [](const pair<double, ListDigraph::Arc> &a,
+          const pair<double, ListDigraph::Arc> &b) {
+         return a.first < b.first;
+       });
+
+  // The bounds of the whole graph hold for every subgraph, so the impacts
+  // of removing the edges one after the other add up.
+  double error = 0.0;
+  bool erased = false;
+  for (auto &impact : impacts) {
+    if (error + impact.first > max_error)
+      break;
+    error += impact.first;
+    g_.erase(impact.second);
+    erased = true;
+  }
+  // also when only edges of no impact went, they may leave dead ends
+  if (erased) {
+    Minimize();
+    IsolateTerminals();
+  }
+  return error;
+}
+
+vector<double> Graph::ReachBounds(bool forward) {
+  string start = forward ? SOURCE : SINK;
+  vector<double> bounds(g_.maxNodeId() + 1, 1.0);
+  // each sweep can only lower the bounds, stop once they settle
+  bool changing = true;
+  for (int sweep = 0; changing && sweep < countNodes(g_); sweep++) {
+    changing = false;
+    for (ListDigraph::NodeIt node(g_); node != INVALID; ++node) {
+      if (nodes_[node] == start)
+        continue;
+      double sum = 0.0;
+      if (forward) {
+        for (ListDigraph::InArcIt arc(g_, node); arc != INVALID; ++arc)
+          sum += weights_[arc] * bounds[g_.id(g_.source(arc))];
+      } else {
+        for (ListDigraph::OutArcIt arc(g_, node); arc != INVALID; ++arc)
+          sum += weights_[arc] * bounds[g_.id(g_.target(arc))];
+      }
+      double bound = min(1.0, sum);
+      if (bound < bounds[g_.id(node)] - 1e-12)
+        changing = true;
+      bounds[g_.id(node)] = bound;
+    }
+  }
+  return bounds;
+}
+
+void Graph::IsolateTerminals() {
   ListDigraph::Node source = name_to_node_[SOURCE];
   ListDigraph::Node sink = name_to_node_[SINK];
   for (ListDigraph::OutArcIt arc(g_, source); arc != INVALID; ++arc) {
@@ -177,22 +322,28 @@ void Graph::RemoveIsolatedNodes() {
   Reverse();
 
   // collect bad nodes
-  for (auto &node : name_to_node_) {
-    if (node.first == SOURCE || node.first == SINK)
-      continue;
-    if (!(forward[g_.id(node.second)] && backward[g_.id(node.second)])) {
-      g_.erase(node.second);
-      name_to_node_.erase(node.first);
+  for (auto node = name_to_node_.begin(); node != name_to_node_.end();) {
+    if (node->first != SOURCE && node->first != SINK &&
+        !(forward[g_.id(node->second)] && backward[g_.id(node->second)])) {
+      g_.erase(node->second);
+      node = name_to_node_.erase(node);
+    } else {
+      ++node;
     }
   }
 }
 
 void Graph::RemoveSelfCycles() {
+  // erasing invalidates the arc iterator, so collect the cycles first
+  vector<ListDigraph::Arc> cycles;
   for (ListDigraph::ArcIt arc(g_); arc != INVALID; ++arc) {
     if (g_.source(arc) == g_.target(arc)) {
-      g_.erase(arc);
+      cycles.push_back(arc);
     }
   }
+  for (auto &arc : cycles) {
+    g_.erase(arc);
+  }
 }
 
 void Graph::CollapseELementaryPaths() {
@@ -236,225 +387,28 @@ void Graph::CollapseELementaryPaths() {
           }
         }
       }
+      // forget the name too, the graph may be minimized again
+      name_to_node_.erase(nodes_[node]);
       g_.erase(node);
       changing = true;
     }
   }
 }
 
-Cut Graph::CreateFirstCut() {
-  auto source = name_to_node_[SOURCE];
-  auto target = name_to_node_[SINK];
-
-  Nodes left;
-  Nodes middle;
-  Nodes right;
-  Edges covered;
-  // initially all nodes are on the right
+OutArcs Graph::GetOutArcs() {
+  OutArcs out_arcs(g_.maxNodeId() + 1);
   for (ListDigraph::NodeIt node(g_); node != INVALID; ++node) {
-    right.set(g_.id(node));
-  }
-  // move source from right to left
-  left.set(g_.id(source));
-  right.reset(g_.id(source));
-  // move nodes adjacent to source from right to middle
-  // and mark covered edges in the process
-  for (ListDigraph::OutArcIt arc(g_, source); arc != INVALID; ++arc) {
-    int endId = g_.id(g_.target(arc));
-    if (endId == g_.id(target)) {
-      return Cut();
-    }
-    covered.set(g_.id(arc));
-    middle.set(endId);
-    right.reset(endId);
-  }
-  // mark as covered: the edges from the middle not going to the right
-  FOREACH_BS(nodeId, middle) {
-    ListDigraph::Node node = g_.nodeFromId(nodeId);
     for (ListDigraph::OutArcIt arc(g_, node); arc != INVALID; ++arc) {
-      if (!right[g_.id(g_.target(arc))]) {
-        covered.set(g_.id(arc));
-      }
-    }
-  }
-
-  // create the cut and recurse
-  return Cut(left, middle, right, covered);
-}
-
-void Graph::RemoveRedundantCuts() {
-  for (size_t i = 0; i < cuts_.size(); i++) {
-    Cut currenti = cuts_.at(i);
-    for (size_t j = i + 1; j < cuts_.size(); j++) {
-      Cut currentj = cuts_.at(j);
-      // see if one of them is contained in the other
-      if (currenti.Overlaps(currentj)) {
-        cuts_.erase(cuts_.begin() + i);
-        i--;
-        break;
-      }
-      if (currentj.Overlaps(currenti)) {
-        cuts_.erase(cuts_.begin() + j);
-        j--;
-      }
-    }
-  }
-}
-
-void Graph::RefineCuts() {
-  ListDigraph::Node target = name_to_node_[SINK];
-  // check for non-minimality: containment of cuts in other cuts
-  RemoveRedundantCuts();
-
-  // grow each cut (if necessary) into a good cut
-  vector<Cut> goodCuts;
-  for (auto &cut : cuts_) {
-    Nodes right = cut.getRight();
-    Nodes middle = cut.getMiddle();
-    Edges covered = cut.getCoveredEdges();
-    // repeat until nothing changes
-    while (true) {
-      // for each node on the right, make sure its outgoing neighbors are all
-      // on the right also
-      vector<int> toAdd;
-      FOREACH_BS(nodeId, right) {
-        ListDigraph::Node node = g_.nodeFromId(nodeId);
-        for (ListDigraph::OutArcIt arc(g_, node); arc != INVALID; ++arc) {
-          // back edge, grow cut with this node
-          if (!right[g_.id(g_.target(arc))]) {
-            toAdd.push_back(nodeId);
-            break;
-          }
-        }
-      }
-      if (toAdd.size() == 0)
-        break;
-      for (auto nodeId : toAdd) {
-        right.reset(nodeId);
-        middle.set(nodeId);
-      }
-    }
-    // Now some new edges can be covered due to moving nodes to the middle
-    // mark these edges as covered
-    FOREACH_BS(nodeId, middle) {
-      ListDigraph::Node middleNode = g_.nodeFromId(nodeId);
-      for (ListDigraph::OutArcIt arc(g_, middleNode); arc != INVALID; ++arc) {
-        if (!right[g_.id(g_.target(arc))]) {
-          covered.set(g_.id(arc));
-        }
-      }
+      out_arcs[g_.id(node)].emplace_back(g_.id(arc), g_.id(g_.target(arc)));
     }
-    // add the new good cut
-    goodCuts.push_back(Cut(cut.getLeft(), middle, right, covered));
   }
-  cuts_ = goodCuts;
-
-  // Minimize good cuts:
-  // If a node in the middle group has no outgoing edges to the right group
-  // Then move it to the left group
-  vector<Cut> bestCuts;
-  for (auto &cut : cuts_) {
-    Nodes middle = cut.getMiddle();
-    Nodes left = cut.getLeft();
-    Nodes right = cut.getRight();
-    vector<int> toMove;
-    FOREACH_BS(nodeId, middle) {
-      // make sure it has at least one edge to the right
-      bool hasRight = false;
-      for (ListDigraph::OutArcIt arc(g_, g_.nodeFromId(nodeId)); arc != INVALID;
-           ++arc) {
-        if (right[g_.id(g_.target(arc))]) {
-          hasRight = true;
-          break;
-        }
-      }
-      if (!hasRight) {
-        toMove.push_back(nodeId);
-      }
-    }
-    for (auto nodeId : toMove) {
-      middle.reset(nodeId);
-      left.set(nodeId);
-    }
-    bestCuts.push_back(Cut(left, middle, right, cut.getCoveredEdges()));
-  }
-  cuts_ = bestCuts;
-
-  // Last: remove redundant cuts again
-  RemoveRedundantCuts();
+  return out_arcs;
 }
 
 vector<Cut> Graph::FindSomeGoodCuts() {
-  ListDigraph::Node target = name_to_node_[SINK];
-  // start by forming the first cut: adjacent to source
-  Cut firstCut = CreateFirstCut();
-  if (firstCut.getMiddle().none()) {
-    // That was a dummy returned cut, i.e. no cuts available.
-    return {firstCut};
-  }
-
-  Nodes currentMiddle = firstCut.getMiddle();
-  Nodes currentLeft = firstCut.getLeft();
-  Nodes currentRight = firstCut.getRight();
-  Edges currentCovered = firstCut.getCoveredEdges();
-
-  cuts_.push_back(firstCut);
-  bool added = true;
-  while (added) { // repeat until nothing new is added
-    Nodes middle = currentMiddle;
-    Nodes left = currentLeft;
-    Nodes right = currentRight;
-    Edges covered = currentCovered;
-    added = false;
-    FOREACH_BS(nodeId, currentMiddle) {
-      ListDigraph::Node node = g_.nodeFromId(nodeId);
-      vector<int> nextNodes;
-      vector<int> nextArcs;
-      for (ListDigraph::OutArcIt arc(g_, node); arc != INVALID; ++arc) {
-        ListDigraph::Node next = g_.target(arc);
-        int nextId = g_.id(next);
-        if (nextId == g_.id(target)) { // node connected to target, ignore all
-                                       // of its neighbors
-          nextNodes.clear();
-          nextArcs.clear();
-          break;
-        } else if (right[nextId]) { // eligible for moving from right to
-                                    // middle
-          nextNodes.push_back(nextId);
-          nextArcs.push_back(g_.id(arc));
-        }
-      }
-      if (nextNodes.size() > 0) { // There are nodes to move from right to left
-        added = true;
-        for (auto nextId : nextNodes) {
-          right.reset(nextId);
-          middle.set(nextId);
-        }
-        for (auto nextId : nextArcs) {
-          covered.set(nextId);
-        }
-        middle.reset(nodeId);
-        left.set(nodeId);
-      }
-    }
-    if (added) {
-      // mark as covered: all edges going from the middle not to the right
-      FOREACH_BS(nodeId, middle) {
-        ListDigraph::Node middleNode = g_.nodeFromId(nodeId);
-        for (ListDigraph::OutArcIt arc(g_, middleNode); arc != INVALID; ++arc) {
-          if (!right[g_.id(g_.target(arc))]) {
-            covered.set(g_.id(arc));
-          }
-        }
-      }
-      Cut newCut(left, middle, right, covered);
-      cuts_.push_back(newCut);
-      currentMiddle = middle;
-      currentLeft = left;
-      currentRight = right;
-      currentCovered = covered;
-    }
-  }
-  RefineCuts();
-  return cuts_;
-}
\ No newline at end of file
+  Nodes nodes = NodesAsBitset();
+  OutArcs out_arcs = GetOutArcs();
+  CutUtil cut_util(nodes, out_arcs, g_.id(name_to_node_[SOURCE]),
+                   g_.id(name_to_node_[SINK]));
+  return cut_util.FindSomeGoodCuts();
+}
@@ -2,11 +2,13 @@
 #define GRAPH_H
 
 #include "Cut.h"
+#include "CutUtil.h"
 #include "Util.h"
 #include <fstream>
 #include <iostream>
 #include <lemon/bfs.h>
 #include <lemon/list_graph.h>
+#include <sstream>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -35,6 +37,12 @@ public:
 
   void CopyFrom(const Graph &graph);
 
+  // Copies the part of graph that matters to a query from one of sources
+  // to one of targets: the edges between nodes reachable from a source
+  // and reaching a target. graph itself is left as is, for the next query.
+  void CopyFrom(const Graph &graph, const vector<string> &sources,
+                const vector<string> &targets);
+
   int CountNodes() { return countNodes(g_); }
 
   int CountArcs() { return countArcs(g_); }
@@ -45,20 +53,47 @@ public:
   // collapse elementary paths
   // see comments of each function for details
   void Preprocess(string sources_file, string targets_file, string pre);
+  void Preprocess(const vector<string> &sources, const vector<string> &targets,
+                  string pre);
 
   void Minimize();
 
-  void UpdateWeights(unordered_map<int, double> edge_weights);
+  // Removes the edges of least impact on the reachability probability, as
+  // long as their impacts add up to at most max_error, then minimizes the
+  // graph again. Removing edges can only lower the probability: the one of
+  // the graph before is between the one after and that plus the returned
+  // bound (the sum of the impacts of the removed edges). The impact of an
+  // edge u --> v is bounded by p * min(reach(u), reach(v)), reach being
+  // upper bounds of the probabilities of reaching u from the source and the
+  // sink from v.
+  double Sparsify(double max_error);
+
+  // Gets all nodes as a bitset.
+  Nodes NodesAsBitset();
 
   // Gets all edges as a bitset.
   Edges EdgesAsBitset();
 
   void GetEdgeInfo(unordered_map<int, EdgeInfo> &edge_info);
 
-  ListDigraph::Node GetNode(string name);
+  ListDigraph::Node GetNode(const string &name);
+
+  // Adds an edge, unless there is one from source to target already.
+  void AddEdge(const string &source, const string &target, double weight);
+
+  string GetName(ListDigraph::Node node) { return nodes_[node]; }
+
+  // Reads whitespace separated node names.
+  static void ReadList(string file_name, vector<string> &list);
+
+  // Splits a comma separated list of node names.
+  static vector<string> SplitNames(const string &list);
 
   ListDigraph &GetInnerG() { return g_; }
 
+  // Gets the out-arcs of every node, indexed by node id.
+  OutArcs GetOutArcs();
+
   // Finds *SOME* good cuts: steps from a cut to the next by
   // replacing every node by all of its neighbors.
   vector<Cut> FindSomeGoodCuts();
@@ -75,23 +110,13 @@ private:
 
   unordered_set<string> edges_;
 
-  vector<Cut> cuts_;
-
   void Create(string &file_name);
 
-  void ReadList(string file_name, vector<string> &list);
-
-  /*Reads sources and targets and adds a unified source and unified sink to the
-   * graph HOW: adds a new SOURCE node to the graph and a 1.0-weight edge to all
+  /*Adds a unified source and unified sink to the graph
+   * HOW: adds a new SOURCE node to the graph and a 1.0-weight edge to all
    * sources same with SINK and all targets*/
-  void UnifyTerminals(string &sourcesFile, string &targetsFile) {
-    vector<string> sources;
-    vector<string> targets;
-
-    // read sources and targets
-    ReadList(sourcesFile, sources);
-    ReadList(targetsFile, targets);
-
+  void UnifyTerminals(const vector<string> &sources,
+                      const vector<string> &targets) {
     // add an edge from the new source to all sources
     for (auto node_name : sources) {
       AddEdge(SOURCE, node_name, 1.0);
@@ -103,7 +128,15 @@ private:
     }
   }
 
-  void AddEdge(string source, string target, double weight);
+  // Makes sure source and sink are not directly connected, by moving a
+  // direct edge behind an ISOLATOR node.
+  void IsolateTerminals();
+
+  // Upper bounds of the probabilities of reaching each node (by id) from
+  // the source, or of reaching the sink from it when !forward: the greatest
+  // fixed point of bound(u) = min(1, sum of p * bound(w) over the edges w
+  // --> u), reached by iterating from 1.
+  vector<double> ReachBounds(bool forward);
 
   // Reverses the graph: replaces each edge by its reverse edge.
   void Reverse();
@@ -139,15 +172,6 @@ private:
   // weight w', we merge the old edge with the new one with a weight =
   // 1-(1-w)(1-w')
   void CollapseELementaryPaths();
-
-  // creates first level cut: nodes adjacent to source*/
-  Cut CreateFirstCut();
-
-  // Minimizes the cuts, then makes sure they are "Good"*/
-  void RefineCuts();
-
-  // removes cuts that are masked by smaller cuts*/
-  void RemoveRedundantCuts();
 };
 
 #endif
\ No newline at end of file
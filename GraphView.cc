@@ -0,0 +1,277 @@
+#include "GraphView.h"
+
+GraphView::GraphView(Graph &graph) {
+  ListDigraph &g = graph.GetInnerG();
+  source_node_ = graph.GetNodeBitset(SOURCE)._Find_first();
+  sink_node_ = graph.GetNodeBitset(SINK)._Find_first();
+  base_nodes_ = graph.NodesAsBitset();
+  base_arcs_ = graph.EdgesAsBitset();
+
+  int num_arc_ids = g.maxArcId() + 1;
+  base_sources_.resize(num_arc_ids);
+  base_targets_.resize(num_arc_ids);
+  base_weights_.resize(num_arc_ids);
+  unordered_map<int, EdgeInfo> edge_info;
+  graph.GetEdgeInfo(edge_info);
+  for (auto &info : edge_info) {
+    base_sources_[info.first] = info.second.edge_terminals.first;
+    base_targets_[info.first] = info.second.edge_terminals.second;
+    base_weights_[info.first] = info.second.p;
+  }
+
+  out_arcs_.resize(NUM_NODES);
+  in_arcs_.resize(NUM_NODES);
+  Reset();
+}
+
+void GraphView::Reset() {
+  // same sizes, so these assignments reuse the existing storage
+  nodes_ = base_nodes_;
+  arcs_ = base_arcs_;
+  sources_ = base_sources_;
+  targets_ = base_targets_;
+  weights_ = base_weights_;
+}
+
+void GraphView::ApplySample(const Sample &sample) {
+  Edges present = sample.present & arcs_;
+  FOREACH_BS(arc, present) { weights_[arc] = 1.0; }
+  arcs_ &= ~sample.absent;
+}
+
+void GraphView::Minimize() {
+  RemoveIsolatedNodes();
+  CollapseElementaryPaths();
+  RemoveSelfCycles();
+}
+
+double GraphView::RemoveDirectArcs() {
+  double miss = 1.0;
+  FOREACH_BS(arc, arcs_) {
+    if (sources_[arc] == source_node_ && targets_[arc] == sink_node_) {
+      miss *= 1.0 - weights_[arc];
+      arcs_.reset(arc);
+    }
+  }
+  return miss;
+}
+
+void GraphView::GetEdgeInfo(unordered_map<int, EdgeInfo> &edge_info) {
+  FOREACH_BS(arc, arcs_) {
+    edge_info[arc].edge_terminals = make_pair(sources_[arc], targets_[arc]);
+    edge_info[arc].p = weights_[arc];
+  }
+}
+
+Nodes GraphView::GetNodeBitset(string node_name) {
+  Nodes node_bitset;
+  node_bitset.set(node_name == SINK ? sink_node_ : source_node_);
+  return node_bitset;
+}
+
+vector<Cut> GraphView::FindSomeGoodCuts() {
+  OutArcs out_arcs(NUM_NODES);
+  FOREACH_BS(arc, arcs_) {
+    out_arcs[sources_[arc]].emplace_back(arc, targets_[arc]);
+  }
+  CutUtil cut_util(nodes_, out_arcs, source_node_, sink_node_);
+  return cut_util.FindSomeGoodCuts();
+}
+
+bool GraphView::ProjectCuts(const vector<Cut> &base_cuts,
+                            vector<Cut> &cuts) {
+  BuildAdjacency();
+  cuts.clear();
+  for (Cut base : base_cuts) {
+    Nodes left = base.getLeft() & nodes_;
+    Nodes middle = base.getMiddle() & nodes_;
+    Nodes right = base.getRight() & nodes_;
+    // repeat until nothing changes
+    bool changing = true;
+    while (changing) {
+      changing = false;
+      Nodes moving;
+      Nodes nodes = right;
+      FOREACH_BS(node, nodes) {
+        for (int arc : out_arcs_[node]) {
+          if (!right[targets_[arc]]) // arc leaving the right
+            moving.set(node);
+        }
+      }
+      nodes = left;
+      FOREACH_BS(node, nodes) {
+        for (int arc : out_arcs_[node]) {
+          if (right[targets_[arc]]) // arc skipping the middle
+            moving.set(targets_[arc]);
+        }
+      }
+      if (moving.any()) {
+        right &= ~moving;
+        middle |= moving;
+        changing = true;
+      }
+    }
+    Nodes nodes = middle;
+    FOREACH_BS(node, nodes) {
+      bool has_right = false;
+      for (int arc : out_arcs_[node]) {
+        has_right = has_right || right[targets_[arc]];
+      }
+      if (!has_right) {
+        middle.reset(node);
+        left.set(node);
+      }
+    }
+    if (middle.none())
+      return false;
+    // same cut as the previous one, once its nodes are dropped
+    if (!cuts.empty() && cuts.back().getLeft() == left &&
+        cuts.back().getMiddle() == middle)
+      continue;
+
+    Edges covered;
+    FOREACH_BS(arc, arcs_) {
+      if (left[sources_[arc]] ||
+          (middle[sources_[arc]] && !right[targets_[arc]]))
+        covered.set(arc);
+    }
+    cuts.emplace_back(left, middle, right, covered);
+  }
+  return ValidChain(cuts);
+}
+
+bool GraphView::ValidChain(vector<Cut> cuts) {
+  Edges consumed;
+  while (cuts.size() > 0) {
+    Cut cut = cuts.front();
+    cuts.erase(cuts.begin());
+    Nodes &right = cut.getRight();
+    if (right[source_node_] || !right[sink_node_])
+      return false;
+    consumed |= cut.getCoveredEdges();
+    FOREACH_BS(arc, arcs_) {
+      bool tail_right = right[sources_[arc]];
+      bool head_right = right[targets_[arc]];
+      if (consumed[arc] ? tail_right || head_right
+                        : !head_right || cut.getLeft()[sources_[arc]])
+        return false;
+    }
+    cuts = cut.RemoveObsoleteCuts(cuts);
+  }
+  return true;
+}
+
+void GraphView::BuildAdjacency() {
+  FOREACH_BS(node, base_nodes_) {
+    out_arcs_[node].clear();
+    in_arcs_[node].clear();
+  }
+  FOREACH_BS(arc, arcs_) {
+    out_arcs_[sources_[arc]].push_back(arc);
+    in_arcs_[targets_[arc]].push_back(arc);
+  }
+}
+
+void GraphView::EraseArc(int arc_id) {
+  auto unlink = [arc_id](vector<int> &arcs) {
+    for (auto &arc : arcs) {
+      if (arc == arc_id) {
+        arc = arcs.back();
+        arcs.pop_back();
+        return;
+      }
+    }
+  };
+  arcs_.reset(arc_id);
+  unlink(out_arcs_[sources_[arc_id]]);
+  unlink(in_arcs_[targets_[arc_id]]);
+}
+
+Nodes GraphView::Reachable(int start, bool forward) {
+  Nodes visited;
+  visited.set(start);
+  stack_.assign(1, start);
+  while (!stack_.empty()) {
+    int node = stack_.back();
+    stack_.pop_back();
+    for (int arc : forward ? out_arcs_[node] : in_arcs_[node]) {
+      int next = forward ? targets_[arc] : sources_[arc];
+      if (!visited[next]) {
+        visited.set(next);
+        stack_.push_back(next);
+      }
+    }
+  }
+  return visited;
+}
+
+void GraphView::RemoveIsolatedNodes() {
+  BuildAdjacency();
+  Nodes keep = Reachable(source_node_, true) & Reachable(sink_node_, false);
+  keep.set(source_node_);
+  keep.set(sink_node_);
+  nodes_ &= keep;
+  FOREACH_BS(arc, arcs_) {
+    if (!nodes_[sources_[arc]] || !nodes_[targets_[arc]]) {
+      arcs_.reset(arc);
+    }
+  }
+}
+
+void GraphView::RemoveSelfCycles() {
+  FOREACH_BS(arc, arcs_) {
+    if (sources_[arc] == targets_[arc]) {
+      arcs_.reset(arc);
+    }
+  }
+}
+
+void GraphView::CollapseElementaryPaths() {
+  // repeat until nothing changes
+  bool changing = true;
+  while (changing) {
+    changing = false;
+    RemoveSelfCycles();
+    BuildAdjacency();
+    Nodes elementary;
+    FOREACH_BS(node, nodes_) {
+      if ((int)node == source_node_ || (int)node == sink_node_)
+        continue;
+      if (in_arcs_[node].size() == 1 && out_arcs_[node].size() == 1) {
+        elementary.set(node);
+      }
+    }
+    // a --> x --> b: link a with b and drop x
+    FOREACH_BS(node, elementary) {
+      // an earlier collapse in this pass may have turned x into a self cycle
+      if (in_arcs_[node].front() == out_arcs_[node].front())
+        continue;
+      int in_arc = in_arcs_[node].front();
+      int out_arc = out_arcs_[node].front();
+      int before = sources_[in_arc];
+      int after = targets_[out_arc];
+      int existing = -1;
+      for (int arc : out_arcs_[before]) {
+        if (targets_[arc] == after) {
+          existing = arc;
+          break;
+        }
+      }
+      if (existing != -1) { // a link already exists, merge with it
+        weights_[existing] =
+            1 - (1 - weights_[existing]) *
+                    (1 - weights_[in_arc] * weights_[out_arc]);
+        EraseArc(in_arc);
+        EraseArc(out_arc);
+      } else { // no existing link, reuse the arc into x for a --> b
+        weights_[in_arc] *= weights_[out_arc];
+        EraseArc(out_arc);
+        targets_[in_arc] = after;
+        in_arcs_[after].push_back(in_arc);
+      }
+      in_arcs_[node].clear();
+      nodes_.reset(node);
+      changing = true;
+    }
+  }
+}
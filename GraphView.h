@@ -0,0 +1,106 @@
+#ifndef GRAPH_VIEW_H
+#define GRAPH_VIEW_H
+
+#include "Cut.h"
+#include "CutUtil.h"
+#include "Graph.h"
+#include "Sample.h"
+#include "Util.h"
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// A lightweight overlay of a preprocessed Graph used by the sampling solvers.
+// The base arcs are kept in flat arrays indexed by the arc ids of the Graph,
+// and sampling / minimization only touch node and arc masks, weight overrides
+// and arc endpoints. Reset() brings the view back to the base graph without
+// any allocation, so a single view can be reused for every iteration instead
+// of copying the LEMON graph each time.
+class GraphView {
+public:
+  GraphView(Graph &graph);
+
+  // Restores the base graph: all masks, weights and endpoints.
+  void Reset();
+
+  int CountNodes() { return nodes_.count(); }
+
+  int CountArcs() { return arcs_.count(); }
+
+  // Fixes the sampled edges: present edges become certain (weight 1) and
+  // absent edges are removed.
+  void ApplySample(const Sample &sample);
+
+  // Same steps as Graph::Minimize, done on the masks.
+  void Minimize();
+
+  // Removes the direct SOURCE --> SINK arcs and returns the probability
+  // that none of them is present. The sausage solver cannot handle such
+  // arcs, they only appear when minimizing collapses a whole path.
+  double RemoveDirectArcs();
+
+  // Gets all edges as a bitset.
+  Edges EdgesAsBitset() { return arcs_; }
+
+  void GetEdgeInfo(unordered_map<int, EdgeInfo> &edge_info);
+
+  // Only SOURCE and SINK can be looked up on a view.
+  Nodes GetNodeBitset(string node_name);
+
+  vector<Cut> FindSomeGoodCuts();
+
+  // Projects cuts found on the base graph onto the view: nodes left out of
+  // the view are dropped, then right nodes move to the middle until no arc
+  // leaves the right nor comes from the left, and middle nodes without arcs
+  // to the right move to the left. Returns false, leaving cuts undefined,
+  // when the projected chain cannot be solved correctly (see ValidChain),
+  // the cuts must then be found again.
+  bool ProjectCuts(const vector<Cut> &base_cuts, vector<Cut> &cuts);
+
+private:
+  int source_node_;
+  int sink_node_;
+
+  // Base graph, as captured at construction.
+  Nodes base_nodes_;
+  Edges base_arcs_;
+  vector<int> base_sources_;
+  vector<int> base_targets_;
+  vector<double> base_weights_;
+
+  // Current state of the view.
+  Nodes nodes_;
+  Edges arcs_;
+  vector<int> sources_;
+  vector<int> targets_;
+  vector<double> weights_;
+
+  // Scratch adjacency (arc ids), indexed by node id. Cleared and refilled
+  // on demand, the inner vectors keep their capacity between iterations.
+  vector<vector<int>> out_arcs_;
+  vector<vector<int>> in_arcs_;
+  vector<int> stack_;
+
+  void BuildAdjacency();
+
+  // Checks the walk of SausageSolver::Solve over cuts: after each cut,
+  // the arcs consumed so far must not touch its right (their states would
+  // be forgotten) and the other arcs must go to its right. SOURCE has to
+  // stay out of the right and SINK in it, the last sausage ending at SINK.
+  bool ValidChain(vector<Cut> cuts);
+
+  void EraseArc(int arc_id);
+
+  // Returns the nodes reachable from start, following arcs forward or
+  // backward.
+  Nodes Reachable(int start, bool forward);
+
+  void RemoveIsolatedNodes();
+
+  void RemoveSelfCycles();
+
+  void CollapseElementaryPaths();
+};
+
+#endif
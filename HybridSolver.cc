@@ -0,0 +1,72 @@
+#include "HybridSolver.h"
+
+double HybridSolver::Solve() {
+  estimate_ = Accumulator();
+
+  // Same walk over the cuts as SausageSolver::Solve(), exact up to the
+  // first sausage over the budget.
+  Edges covered;
+  int width = source_.count();
+  while (cuts_.size() > 0) {
+    Cut nextCut = cuts_.front();
+    Edges sausage = nextCut.getCoveredEdges() & ~covered;
+    if (SausageCost(sausage.count(), width) > budget_)
+      break;
+    cuts_.erase(cuts_.begin());
+    ConsumeSausage(sausage, nextCut.getMiddle());
+    covered |= sausage;
+    width = nextCut.size();
+    cuts_ = nextCut.RemoveObsoleteCuts(cuts_);
+  }
+  Edges last = all_edges_ & ~covered;
+  if (cuts_.empty() && SausageCost(last.count(), width) <= budget_) {
+    ConsumeSausage(last, target_);
+    return P_.GetResult();
+  }
+
+  // the iterations go on from there, each from a copy of the state
+  Polynomial start = P_;
+  unordered_map<int, EdgeInfo> start_edge_info = edge_info_;
+  for (int i = 0; i < num_iteration_; i++) {
+    rng_ = Philox(seed_, i);
+    P_ = start;
+    edge_info_ = start_edge_info;
+    vector<Cut> cuts = cuts_;
+    Edges iteration_covered = covered;
+    int iteration_width = width;
+    while (cuts.size() > 0) {
+      Cut nextCut = cuts.front();
+      cuts.erase(cuts.begin());
+      Edges sausage = nextCut.getCoveredEdges() & ~iteration_covered;
+      SampleEdges(sausage, iteration_width);
+      ConsumeSausage(sausage, nextCut.getMiddle());
+      iteration_covered |= sausage;
+      iteration_width = nextCut.size();
+      cuts = nextCut.RemoveObsoleteCuts(cuts);
+    }
+    Edges sausage = all_edges_ & ~iteration_covered;
+    SampleEdges(sausage, iteration_width);
+    ConsumeSausage(sausage, target_);
+    estimate_.Add(P_.GetResult());
+  }
+  return estimate_.Mean();
+}
+
+void HybridSolver::SampleEdges(Edges &sausage, int width) {
+  int exact = sausage.count();
+  while (exact > 0 && SausageCost(exact, width) > budget_) {
+    exact--;
+  }
+  if (exact == (int)sausage.count())
+    return;
+
+  // a uniformly random choice of the edges to sample, independent of
+  // their states
+  sausage_edges_.clear();
+  FOREACH_BS(edge_id, sausage) { sausage_edges_.push_back(edge_id); }
+  shuffle(sausage_edges_.begin(), sausage_edges_.end(), rng_);
+  for (size_t i = exact; i < sausage_edges_.size(); i++) {
+    EdgeInfo &info = edge_info_[sausage_edges_[i]];
+    info.p = rng_() < ProbabilityThreshold(info.p) ? 1.0 : 0.0;
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef HYBRID_SOLVER_H
+#define HYBRID_SOLVER_H
+
+#include "Accumulator.h"
+#include "Graph.h"
+#include "Philox.h"
+#include "Sample.h"
+#include "SausageSolver.h"
+#include <algorithm>
+#include <vector>
+
+// Sausage-by-sausage hybrid of the exact solver and sampling. Sausages
+// predicted cheap enough (see SausageSolver::SausageCost) are consumed
+// exactly. In the others, the states of just enough randomly chosen edges
+// are sampled to bring the sausage under the budget, the remaining edges
+// being consumed exactly over the exact distribution of the terms coming
+// in. Each iteration is thus an unbiased estimate, computed exactly but
+// for the wide sausages; the sausages before the first wide one are only
+// consumed once, for all the iterations.
+class HybridSolver : public SausageSolver {
+public:
+  HybridSolver(Graph &graph, int num_iteration, double budget,
+               uint64_t seed)
+      : SausageSolver(graph), num_iteration_(num_iteration), budget_(budget),
+        seed_(seed) {}
+
+  double Solve();
+
+  // Statistics of the per-iteration estimates of the last Solve(), none
+  // when no sausage is over the budget (the result is then exact).
+  const Accumulator &GetEstimate() { return estimate_; }
+
+private:
+  int num_iteration_;
+
+  // Largest predicted cost of a sausage consumed exactly.
+  double budget_;
+
+  uint64_t seed_;
+
+  // Random stream of the current iteration, stream i for iteration i.
+  Philox rng_;
+
+  Accumulator estimate_;
+
+  vector<int> sausage_edges_;
+
+  // Samples the states of edges of sausage (fixing their weights to 0 or
+  // 1 in edge_info_) until the rest is within the budget.
+  void SampleEdges(Edges &sausage, int width);
+};
+
+#endif
@@ -0,0 +1,37 @@
+#include "LaneBfs.h"
+
+LaneBfs::LaneBfs(const OutArcs &out_arcs)
+    : out_arcs_(out_arcs), reached_(out_arcs.size()),
+      queued_(out_arcs.size(), 0) {}
+
+const vector<Lanes> &LaneBfs::Reach(const Lanes *arc_lanes,
+                                    const vector<int> &sources, int stop) {
+  for (auto &lanes : reached_) {
+    lanes = 0;
+  }
+  queue_.clear();
+  for (int node : sources) {
+    reached_[node] = ~Lanes(0);
+    if (!queued_[node]) {
+      queued_[node] = 1;
+      queue_.push_back(node);
+    }
+  }
+  while (!queue_.empty()) {
+    int node = queue_.back();
+    queue_.pop_back();
+    queued_[node] = 0;
+    for (auto &arc : out_arcs_[node]) {
+      int next = arc.second;
+      Lanes added = reached_[node] & arc_lanes[arc.first] & ~reached_[next];
+      if (added) {
+        reached_[next] |= added;
+        if (!queued_[next] && next != stop) {
+          queued_[next] = 1;
+          queue_.push_back(next);
+        }
+      }
+    }
+  }
+  return reached_;
+}
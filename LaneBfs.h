@@ -0,0 +1,37 @@
+#ifndef LANE_BFS_H
+#define LANE_BFS_H
+
+#include "CutUtil.h"
+#include "Util.h"
+#include <vector>
+
+using namespace std;
+
+// Word-parallel BFS over NUM_LANES worlds at once, one world per bit lane:
+// a node is revisited whenever it is reached in new lanes, and only those
+// new lanes are pushed further. Shared by the Monte Carlo solver, the
+// sample batches and the world index.
+class LaneBfs {
+public:
+  LaneBfs() = default;
+
+  // out_arcs lists (lane index, target) pairs, the lane index being where
+  // the arc's lanes are in the arc_lanes of Reach.
+  LaneBfs(const OutArcs &out_arcs);
+
+  // Lanes in which each node is reached from one of sources through the
+  // arcs present in arc_lanes. stop (-1 for none) is not traversed past,
+  // for when only reaching it matters. Valid until the next call.
+  const vector<Lanes> &Reach(const Lanes *arc_lanes,
+                             const vector<int> &sources, int stop = -1);
+
+private:
+  OutArcs out_arcs_;
+
+  // Scratch space, indexed by node.
+  vector<Lanes> reached_;
+  vector<int> queue_;
+  vector<char> queued_;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "Lattice.h"
+#include <algorithm>
+#include <cmath>
+
+// Operations spent at most on searching the multiplier.
+const double SEARCH_BUDGET = 2e7;
+
+// Multipliers tried at most.
+const int MAX_CANDIDATES = 64;
+
+static uint64_t GreatestCommonDivisor(uint64_t a, uint64_t b) {
+  while (b != 0) {
+    uint64_t rest = a % b;
+    a = b;
+    b = rest;
+  }
+  return a;
+}
+
+Lattice::Lattice(int num_points, int dims) : num_points_(max(num_points, 1)) {
+  generator_ = Generator(1, dims);
+  if (num_points_ <= 2 || dims <= 1)
+    return;
+
+  // Candidates are spread over [2, n) by the golden ratio, those sharing a
+  // factor with n are skipped: their points would not cover the grid.
+  double cost = (double)num_points_ * dims;
+  int num_candidates =
+      max(1, min(MAX_CANDIDATES, (int)(SEARCH_BUDGET / cost)));
+  double best = INFINITY;
+  double golden = (sqrt(5.0) - 1.0) / 2.0;
+  for (int i = 1, tried = 0; tried < num_candidates && i < 4 * num_candidates;
+       i++) {
+    double position = i * golden - floor(i * golden);
+    uint64_t multiplier = 2 + (uint64_t)(position * (num_points_ - 2));
+    if (GreatestCommonDivisor(multiplier, num_points_) != 1)
+      continue;
+    tried++;
+    vector<uint64_t> generator = Generator(multiplier, dims);
+    double criterion = Criterion(generator);
+    if (criterion < best) {
+      best = criterion;
+      multiplier_ = multiplier;
+      generator_ = generator;
+    }
+  }
+}
+
+vector<uint64_t> Lattice::Generator(uint64_t multiplier, int dims) const {
+  vector<uint64_t> generator(max(dims, 0));
+  uint64_t power = 1;
+  for (auto &z : generator) {
+    z = power;
+    power = power * multiplier % num_points_;
+  }
+  return generator;
+}
+
+double Lattice::Criterion(const vector<uint64_t> &generator) const {
+  // Equal weights of 1 / (dims + 1): the one-dimensional terms are the
+  // same for every multiplier, so the pairs of coordinates dominate.
+  double weight = 2.0 * M_PI * M_PI / (generator.size() + 1);
+  double sum = 0.0;
+  for (int k = 0; k < num_points_; k++) {
+    double product = 1.0;
+    for (auto z : generator) {
+      double x = (double)(k * z % num_points_) / num_points_;
+      // Bernoulli polynomial B2
+      product *= 1.0 + weight * (x * x - x + 1.0 / 6.0);
+    }
+    sum += product;
+  }
+  return sum / num_points_ - 1.0;
+}
@@ -0,0 +1,44 @@
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Rank-1 lattice rule of Korobov type: point k of n has coordinates
+// frac(k * a^j / n), j = 0 .. dims - 1. Every one-dimensional projection is
+// the regular grid {0, 1/n, ..., (n-1)/n}, and a is searched so that the
+// two-dimensional projections are well spread too. Shifted by a uniform
+// random vector (mod 1), the points make an unbiased quasi-Monte Carlo
+// replicate.
+class Lattice {
+public:
+  Lattice() = default;
+  Lattice(int num_points, int dims);
+
+  int NumPoints() const { return num_points_; }
+  int Dimension() const { return generator_.size(); }
+  uint64_t Multiplier() const { return multiplier_; }
+
+  // Coordinate dim of point k, scaled to 32 bits, unshifted. Adding a
+  // random 32 bit shift (wrapping around) gives a uniform draw.
+  uint32_t Coordinate(int point, int dim) const {
+    return ((uint64_t(point) * generator_[dim] % num_points_) << 32) /
+           num_points_;
+  }
+
+private:
+  int num_points_ = 1;
+  uint64_t multiplier_ = 1;
+  // a^j mod n.
+  vector<uint64_t> generator_;
+
+  // Weighted P2 criterion of the lattice with generator z, lower is
+  // better: the worst-case error for periodic integrands of smoothness 2.
+  double Criterion(const vector<uint64_t> &generator) const;
+
+  vector<uint64_t> Generator(uint64_t multiplier, int dims) const;
+};
+
+#endif
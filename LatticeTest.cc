@@ -0,0 +1,34 @@
+#include "Lattice.h"
+#include "gtest/gtest.h"
+
+namespace {
+TEST(LatticeTest, ProjectionsTest) {
+  // every coordinate of the points is a permutation of the grid
+  for (int num_points : {1, 97, 256, 1000}) {
+    Lattice lattice(num_points, 12);
+    EXPECT_EQ(lattice.NumPoints(), num_points);
+    EXPECT_EQ(lattice.Dimension(), 12);
+    for (int dim = 0; dim < 12; dim++) {
+      vector<bool> seen(num_points, false);
+      for (int k = 0; k < num_points; k++) {
+        uint64_t cell = ((uint64_t)lattice.Coordinate(k, dim) * num_points +
+                         num_points - 1) >> 32;
+        ASSERT_LT(cell, (uint64_t)num_points);
+        EXPECT_FALSE(seen[cell]);
+        seen[cell] = true;
+      }
+    }
+  }
+}
+
+TEST(LatticeTest, PairsTest) {
+  // no two coordinates may be the same: the multiplier must have a large
+  // enough order
+  Lattice lattice(1021, 20);
+  for (int i = 0; i < 20; i++) {
+    for (int j = i + 1; j < 20; j++) {
+      EXPECT_NE(lattice.Coordinate(1, i), lattice.Coordinate(1, j));
+    }
+  }
+}
+} // namespace
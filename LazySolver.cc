@@ -0,0 +1,69 @@
+#include "LazySolver.h"
+#include <algorithm>
+#include <cmath>
+
+LazySolver::LazySolver(Graph &graph, int num_samples, uint64_t seed)
+    : Solver(graph), num_samples_(num_samples), out_arcs_(NUM_NODES),
+      seed_(seed) {
+  source_node_ = source_._Find_first();
+  sink_node_ = target_._Find_first();
+  FOREACH_BS(edge_id, all_edges_) {
+    EdgeInfo &info = edge_info_[edge_id];
+    // an absent arc would make its skip infinite
+    if (info.p <= 0.0)
+      continue;
+    // log1p, as 1 - p rounds to 1 for tiny p
+    out_arcs_[info.edge_terminals.first].push_back(
+        {info.edge_terminals.second, info.p, log1p(-info.p)});
+  }
+  for (auto &arcs : out_arcs_) {
+    sort(arcs.begin(), arcs.end(),
+         [](const Arc &a, const Arc &b) { return a.p > b.p; });
+  }
+}
+
+double LazySolver::Solve() {
+  int reaching = 0;
+  for (int i = 0; i < num_samples_; i++) {
+    rng_ = Philox(seed_, i);
+    if (SampleWorld())
+      reaching++;
+  }
+  return double(reaching) / double(num_samples_);
+}
+
+bool LazySolver::SampleWorld() {
+  Nodes visited;
+  visited.set(source_node_);
+  stack_.assign(1, source_node_);
+  while (!stack_.empty()) {
+    vector<Arc> &arcs = out_arcs_[stack_.back()];
+    stack_.pop_back();
+    size_t i = 0;
+    while (i < arcs.size()) {
+      // The arcs from i on are at most as likely as arc i: skip the ones
+      // failing a trial with probability q = p_i all at once, then thin
+      // the first success down to the arc's own probability.
+      double q = arcs[i].p;
+      if (q < 1.0) {
+        double skip = floor(log(NextRand()) / arcs[i].log_absent);
+        if (skip >= arcs.size() - i)
+          break;
+        i += (size_t)skip;
+        if (arcs[i].p < q && NextRand() > arcs[i].p / q) {
+          i++;
+          continue;
+        }
+      }
+      int next = arcs[i].target;
+      if (next == sink_node_)
+        return true;
+      if (!visited[next]) {
+        visited.set(next);
+        stack_.push_back(next);
+      }
+      i++;
+    }
+  }
+  return false;
+}
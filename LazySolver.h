@@ -0,0 +1,53 @@
+#ifndef LAZY_SOLVER_H
+#define LAZY_SOLVER_H
+
+#include "Graph.h"
+#include "Philox.h"
+#include "Solver.h"
+#include "Util.h"
+#include <vector>
+
+// Monte Carlo estimate of the reachability probability that samples edge
+// states lazily: an arc is only drawn when the traversal of the current
+// world reaches its tail, and a world stops as soon as SINK is reached.
+// Out-arcs are sorted by decreasing probability and visited with
+// geometric skipping, so runs of unlikely arcs cost a single draw.
+class LazySolver : public Solver {
+public:
+  LazySolver(Graph &graph, int num_samples, uint64_t seed);
+
+  double Solve();
+
+private:
+  struct Arc {
+    int target;
+    double p;
+    // log(1 - p) < 0, used for the geometric skips. Unused when p is 1.
+    double log_absent;
+  };
+
+  int num_samples_;
+
+  // Out-arcs of every node by decreasing probability, indexed by node id.
+  // Arcs of probability 0 are left out.
+  vector<vector<Arc>> out_arcs_;
+
+  int source_node_;
+  int sink_node_;
+
+  uint64_t seed_;
+
+  // Random stream of the current world.
+  Philox rng_;
+
+  // Scratch stack of the traversal.
+  vector<int> stack_;
+
+  // Get a random number in (0, 1].
+  double NextRand() { return 1.0 - rng_.NextDouble(); }
+
+  // Samples one world lazily, returns true if SINK is reached.
+  bool SampleWorld();
+};
+
+#endif
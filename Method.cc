@@ -0,0 +1,205 @@
+#include "Method.h"
+#include "BitParallelSolver.h"
+#include "HybridSolver.h"
+#include "LazySolver.h"
+#include "RandomSolver.h"
+#include "RssSolver.h"
+#include "SamplingSolver.h"
+#include "SausageSolver.h"
+#include <fstream>
+#include <memory>
+
+void ParseArgs(const vector<string> &fields, vector<string> &args,
+               unordered_map<string, string> &options) {
+  for (size_t i = 0; i < fields.size(); i++) {
+    if (fields[i].compare(0, 2, "--") == 0 && i + 1 < fields.size()) {
+      options[fields[i].substr(2)] = fields[i + 1];
+      i++;
+    } else {
+      args.push_back(fields[i]);
+    }
+  }
+}
+
+int ThreadsOption(unordered_map<string, string> &options) {
+  return options.count("threads") ? stoi(options["threads"]) : 0;
+}
+
+double Seconds(const timeval &start, const timeval &end) {
+  return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+uint64_t ChooseSeed(unordered_map<string, string> &options) {
+  if (options.count("seed"))
+    return stoull(options["seed"]);
+  timeval time;
+  gettimeofday(&time, NULL);
+  return (time.tv_sec * 1000) + (time.tv_usec / 1000);
+}
+
+// Whether token is a positive int, all of it: stoi alone reads 0.9 as 0.
+static bool IsCount(const string &token) {
+  size_t end = 0;
+  try {
+    return stoi(token, &end) > 0 && end == token.size();
+  } catch (exception &) {
+    return false;
+  }
+}
+
+// Positions in method of the iteration and sample counts of method[0], the
+// solvers divide by them.
+static vector<size_t> CountPositions(const string &choice) {
+  if (choice == "random" || choice == "sausage")
+    return {};
+  if (choice == "sausage-hybrid" || choice == "mc-bitparallel" ||
+      choice == "mc-lazy")
+    return {1};
+  if (choice == "sample-rss")
+    return {1, 2};
+  return {2};
+}
+
+bool RunMethod(Graph &graph, const vector<string> &method,
+               unordered_map<string, string> &options, uint64_t seed,
+               ThreadPool &pool, MethodResult &result) {
+  unique_ptr<Solver> solver;
+  double &prob = result.prob;
+  Accumulator &estimate = result.estimate;
+
+  string choice = method.at(0);
+  for (size_t i : CountPositions(choice)) {
+    if (i < method.size() && !IsCount(method[i])) {
+      result.error = "invalid parameters: " + method[i] +
+                     " is not a positive count";
+      return false;
+    }
+  }
+  if (options.count("qmc") && !IsCount(options["qmc"])) {
+    result.error = "invalid parameters: --qmc " + options["qmc"] +
+                   " is not a positive count";
+    return false;
+  }
+
+  if (choice == "random") {
+    solver = make_unique<RandomSolver>(graph, seed);
+    prob = solver->Solve();
+  } else if (choice == "sausage") {
+    solver = make_unique<SausageSolver>(graph);
+    prob = solver->Solve();
+  } else if (choice == "sausage-hybrid") {
+    int num_iteration = stoi(method.at(1));
+    double budget = stod(method.at(2));
+    HybridSolver hybrid(graph, num_iteration, budget, seed);
+    prob = hybrid.Solve();
+    estimate = hybrid.GetEstimate();
+  } else if (choice == "mc-bitparallel") {
+    int num_samples = stoi(method.at(1));
+    solver = make_unique<BitParallelSolver>(graph, num_samples, seed);
+    prob = solver->Solve();
+  } else if (choice == "mc-lazy") {
+    int num_samples = stoi(method.at(1));
+    solver = make_unique<LazySolver>(graph, num_samples, seed);
+    prob = solver->Solve();
+  } else if (choice == "sample-rss") {
+    int num_samples = stoi(method.at(1));
+    int num_strata_edges = method.size() > 2 ? stoi(method.at(2)) : 4;
+    int threshold = method.size() > 3 ? stoi(method.at(3)) : 10;
+    solver = make_unique<RssSolver>(graph, num_samples, num_strata_edges,
+                                    threshold, seed);
+    prob = solver->Solve();
+  } else {
+    double success_prob = stod(method.at(1));
+    int num_iteration = stoi(method.at(2)), probe_size = 0, probe_repeat = 0;
+    double epsilon = options.count("epsilon") ? stod(options["epsilon"]) : 0.0;
+    bool timed_probe = options["probe"] == "timed";
+    int replicates = options.count("qmc") ? stoi(options["qmc"]) : 0;
+    if (replicates > num_iteration ||
+        (replicates > 0 && epsilon > 0.0)) {
+      // replicates are only unbiased once complete
+      result.error = "--qmc needs between 1 and num-iterations replicates, "
+                     "and no --epsilon";
+      return false;
+    }
+    bool fixed = false, weighted = false;
+    bool importance = choice == "sample-importance";
+    if (choice != "sample-random" && !importance) {
+      fixed = true;
+      probe_size = stoi(method.at(3));
+      probe_repeat = stoi(method.at(4));
+      weighted = choice == "sample-weighted";
+    }
+    SamplingSolver sol(graph, num_iteration, success_prob, probe_size,
+                       probe_repeat, fixed, weighted, importance, epsilon,
+                       timed_probe, seed, &pool, replicates);
+
+    int shard = 0, num_shards = 0;
+    if (options.count("shard")) {
+      if (sscanf(options["shard"].c_str(), "%d/%d", &shard, &num_shards) != 2 ||
+          shard < 0 || shard >= num_shards) {
+        result.error = "Invalid shard, expected i/N with 0 <= i < N";
+        return false;
+      }
+      // every shard must draw from the same streams and sample the same
+      // edges (timed probing chooses them by timings), and stopping early
+      // depends on the iterations before
+      if (!options.count("seed") || epsilon > 0.0 || timed_probe) {
+        result.error =
+            "--shard needs --seed, and neither --epsilon nor --probe timed";
+        return false;
+      }
+      // with --qmc, shards take whole replicates
+      long long unit = 1, num_units = num_iteration;
+      if (replicates > 0) {
+        unit = num_iteration / replicates;
+        num_units = replicates;
+      }
+      long long first = num_units * shard / num_shards * unit;
+      long long end = num_units * (shard + 1) / num_shards * unit;
+      sol.SetIterations(first, end - first);
+    }
+
+    timeval start, end;
+    gettimeofday(&start, NULL);
+    prob = sol.Solve();
+    gettimeofday(&end, NULL);
+    estimate = sol.GetEstimate();
+    if (replicates > 0) {
+      result.unit = " replicates of " + to_string(num_iteration / replicates) +
+                    " iterations";
+    }
+
+    if (num_shards > 0) {
+      string file = options.count("shard-file")
+                        ? options["shard-file"]
+                        : "shard-" + to_string(shard) + "-of-" +
+                              to_string(num_shards) + ".txt";
+      ofstream out(file);
+      estimate.Write(out);
+      out << "seconds " << Seconds(start, end) << endl
+          << "unit" << result.unit << endl;
+    }
+  }
+
+  return true;
+}
+
+string TrySolve(Graph &graph, const vector<string> &method,
+                unordered_map<string, string> &options, uint64_t seed,
+                ThreadPool &pool, MethodResult &result) {
+  ListDigraph &g = graph.GetInnerG();
+  if (g.maxNodeId() >= NUM_NODES || g.maxArcId() >= NUM_EDGES) {
+    return "graph too large: " + to_string(graph.CountNodes()) + " nodes, " +
+           to_string(graph.CountArcs()) + " edges after preprocessing";
+  }
+  try {
+    if (options.count("sparsify") && graph.CountArcs() > 0)
+      result.sparsify_error = graph.Sparsify(stod(options["sparsify"]));
+    if (graph.CountArcs() > 0 &&
+        !RunMethod(graph, method, options, seed, pool, result))
+      return result.error;
+  } catch (exception &e) {
+    return string("invalid parameters: ") + e.what();
+  }
+  return "";
+}
@@ -0,0 +1,60 @@
+#ifndef METHOD_H
+#define METHOD_H
+
+#include "Accumulator.h"
+#include "Graph.h"
+#include "ThreadPool.h"
+#include <string>
+#include <sys/time.h>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Result of a method on a graph.
+struct MethodResult {
+  double prob = 0.0;
+  // error estimate, for the sampled methods only
+  Accumulator estimate;
+  // what each value of estimate is the result of
+  string unit = " iterations";
+  // why RunMethod failed
+  string error;
+  // how much higher the probability may be before --sparsify, set by
+  // TrySolve
+  double sparsify_error = 0.0;
+};
+
+// Splits fields into the --name value options, which may appear anywhere,
+// and the positional args.
+void ParseArgs(const vector<string> &fields, vector<string> &args,
+               unordered_map<string, string> &options);
+
+// The --threads option, else 0 (one thread per core).
+int ThreadsOption(unordered_map<string, string> &options);
+
+// Seconds from start to end.
+double Seconds(const timeval &start, const timeval &end);
+
+// The --seed option, else the current time.
+uint64_t ChooseSeed(unordered_map<string, string> &options);
+
+// Runs the method method[0] on the preprocessed graph, method[1...] being
+// its parameters and options the --name value options, as on the command
+// line. Returns false, saying why in result.error, for invalid options and
+// counts; other missing or malformed parameters throw (out_of_range,
+// invalid_argument).
+// pool runs the sample-* methods.
+bool RunMethod(Graph &graph, const vector<string> &method,
+               unordered_map<string, string> &options, uint64_t seed,
+               ThreadPool &pool, MethodResult &result);
+
+// Runs method on graph like RunMethod, but returns what went wrong instead
+// of throwing, "" if nothing did: also a graph too large for the solvers.
+// An empty graph has a probability of 0. With --sparsify, graph is first
+// sparsified (see Graph::Sparsify).
+string TrySolve(Graph &graph, const vector<string> &method,
+                unordered_map<string, string> &options, uint64_t seed,
+                ThreadPool &pool, MethodResult &result);
+
+#endif
@@ -1,30 +1,459 @@
+#include "Accumulator.h"
 #include "Cut.h"
 #include "Graph.h"
-#include "RandomSolver.h"
-#include "SamplingSolver.h"
+#include "Method.h"
+#include "QueryServer.h"
 #include "SausageSolver.h"
+#include "ThreadPool.h"
 #include "Util.h"
+#include "WorldIndex.h"
+#include <atomic>
 #include <fstream>
 #include <lemon/bfs.h>
 #include <lemon/list_graph.h>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <sstream>
+#include <sys/time.h>
 
 using namespace std;
 
+// Combines the accumulator files written by --shard runs into the final
+// estimate, exactly the one of a single run over all the iterations.
+int MergeShards(vector<string> &files) {
+  Accumulator estimate;
+  double seconds = 0.0;
+  string unit;
+  for (auto &file : files) {
+    ifstream in(file);
+    Accumulator shard;
+    string name, shard_unit;
+    double shard_seconds;
+    if (!shard.Read(in) || !(in >> name >> shard_seconds) ||
+        name != "seconds" || !(in >> name) || name != "unit" ||
+        !getline(in, shard_unit)) {
+      cerr << "Invalid shard file: " << file << endl;
+      return -1;
+    }
+    // --qmc shards hold replicate means, not iteration values
+    if (!unit.empty() && shard_unit != unit) {
+      cerr << "Shards counting different units:" << unit << " vs"
+           << shard_unit << endl;
+      return -1;
+    }
+    unit = shard_unit;
+    estimate.Merge(shard);
+    seconds += shard_seconds;
+  }
+  cout << "Reachability probability: " << estimate.Mean() << endl
+       << "95% confidence interval: ["
+       << estimate.Mean() - estimate.HalfWidth() << ", "
+       << estimate.Mean() + estimate.HalfWidth() << "] after "
+       << estimate.Count() << unit << endl
+       << "Shards: " << files.size() << ", total time: " << seconds << "s"
+       << endl;
+  return 0;
+}
+
+// Prints the estimate of the sampled methods and its 95% confidence
+// interval, unit naming what each value of estimate is the result of.
+void PrintEstimate(double prob, Accumulator &estimate, string unit) {
+  cout << "Reachability probability: " << prob << endl;
+  if (estimate.Count() > 0) {
+    cout << "95% confidence interval: [" << prob - estimate.HalfWidth()
+         << ", " << prob + estimate.HalfWidth() << "] after "
+         << estimate.Count() << unit << endl;
+  }
+}
+
+// Samples the possible worlds of a whole network once and saves them, see
+// WorldIndex.
+int BuildIndex(vector<string> &args, uint64_t seed) {
+  cout << "Seed: " << seed << endl;
+  Graph graph(args[2]);
+  WorldIndex index(graph, stoi(args[3]), seed);
+  ofstream out(args[4], ios::binary);
+  index.Write(out);
+  cout << "Indexed " << index.NumWorlds() << " worlds of "
+       << index.NumNodes() << " nodes, " << index.NumArcs() << " edges"
+       << endl;
+  return out ? 0 : -1;
+}
+
+// Answers each (sources-file, targets-file) pair of args from a saved
+// index.
+int QueryIndex(vector<string> &args) {
+  ifstream in(args[2], ios::binary);
+  WorldIndex index;
+  if (!index.Read(in)) {
+    cerr << "Invalid index file: " << args[2] << endl;
+    return -1;
+  }
+  for (size_t i = 3; i + 1 < args.size(); i += 2) {
+    vector<string> sources, targets;
+    Graph::ReadList(args[i], sources);
+    Graph::ReadList(args[i + 1], targets);
+    Accumulator estimate;
+    double prob = index.Query(sources, targets, estimate);
+    cout << args[i] << " " << args[i + 1] << endl;
+    PrintEstimate(prob, estimate, " worlds");
+  }
+  return 0;
+}
+
+// Solves the preprocessed graph with the method method[0], method[1...]
+// being its parameters as on the command line, and prints the result.
+int SolveGraph(Graph &graph, vector<string> &method,
+               unordered_map<string, string> &options, uint64_t seed,
+               ThreadPool &pool) {
+  int numNodes = graph.CountNodes();
+  int numEdges = graph.CountArcs();
+  cout << endl
+       << "Modified graph size: " << numNodes << " nodes, " << numEdges
+       << " edges" << endl
+       << endl;
+
+  // removing edges only lowers the probability, by at most sparsify_error
+  double sparsify_error = 0.0;
+  if (options.count("sparsify")) {
+    sparsify_error = graph.Sparsify(stod(options["sparsify"]));
+    numEdges = graph.CountArcs();
+    cout << "Sparsified graph size: " << graph.CountNodes() << " nodes, "
+         << numEdges << " edges, error bound: " << sparsify_error << endl
+         << endl;
+  }
+
+  if (numEdges == 0) {
+    // empty graph - source and target unreachable
+    cout << "0.0" << endl;
+    return 0;
+  }
+
+  cout << "Seed: " << seed << endl;
+
+  MethodResult result;
+  if (!RunMethod(graph, method, options, seed, pool, result)) {
+    cerr << result.error << endl;
+    return -1;
+  }
+  double prob = result.prob;
+
+  PrintEstimate(prob, result.estimate, result.unit);
+  if (options.count("sparsify")) {
+    cout << "Before sparsification: up to " << sparsify_error << " more"
+         << endl;
+  }
+  return 0;
+}
+
+// Whether --shard is given, which only runs of a single query support
+// (saying so on cerr).
+bool RejectShard(unordered_map<string, string> &options) {
+  if (!options.count("shard"))
+    return false;
+  cerr << "--shard runs a single query" << endl;
+  return true;
+}
+
+// A query of a query file: comma separated sources and targets.
+struct Query {
+  string sources;
+  string targets;
+};
+
+// Reads a query file, one query per line: comma separated sources, then
+// comma separated targets (lines starting with # are skipped).
+vector<Query> ReadQueries(const string &file_name) {
+  vector<Query> queries;
+  ifstream in(file_name);
+  string line;
+  while (getline(in, line)) {
+    stringstream fields(line);
+    Query query;
+    if ((fields >> query.sources >> query.targets) && query.sources[0] != '#')
+      queries.push_back(query);
+  }
+  return queries;
+}
+
+// Copies the part of network relevant to query and preprocesses it.
+void PrepareQuery(const Graph &network, const Query &query, Graph &graph) {
+  vector<string> sources = Graph::SplitNames(query.sources);
+  vector<string> targets = Graph::SplitNames(query.targets);
+  graph.CopyFrom(network, sources, targets);
+  graph.Preprocess(sources, targets, PRE_YES);
+}
+
+// Quotes text as a JSON string.
+string JsonString(const string &text) {
+  string quoted = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if ((unsigned char)c < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      quoted += escaped;
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+// Adds the JSON fields of a result to line: the probability (and for the
+// sampled methods the confidence half width and number of values, with
+// --sparsify its error bound), else the error. Returns whether there was no
+// error.
+bool AddJsonResult(ostream &line, MethodResult &result, const string &error,
+                   unordered_map<string, string> &options) {
+  if (!error.empty()) {
+    line << ", \"error\": " << JsonString(error);
+    return false;
+  }
+  Accumulator &estimate = result.estimate;
+  line << ", \"probability\": " << result.prob;
+  if (estimate.Count() > 0) {
+    line << ", \"half_width\": " << estimate.HalfWidth()
+         << ", \"values\": " << estimate.Count();
+  }
+  if (options.count("sparsify"))
+    line << ", \"sparsify_error\": " << result.sparsify_error;
+  return true;
+}
+
+// Answers every query of a query file (see ReadQueries). The network is
+// read once, each query preprocessing its own copy of the part of the
+// network relevant to it.
+int RunQueries(vector<string> &args, unordered_map<string, string> &options) {
+  if (RejectShard(options))
+    return -1;
+  Graph network(args[2]);
+  cout << endl
+       << "Original graph size: " << network.CountNodes() << " nodes, "
+       << network.CountArcs() << " edges" << endl;
+
+  uint64_t seed = ChooseSeed(options);
+  ThreadPool pool(ThreadsOption(options));
+  vector<string> method(args.begin() + 4, args.end());
+  int status = 0;
+  for (auto &query : ReadQueries(args[3])) {
+    cout << endl << "Query: " << query.sources << " " << query.targets << endl;
+    Graph graph;
+    PrepareQuery(network, query, graph);
+    if (SolveGraph(graph, method, options, seed, pool) != 0)
+      status = -1;
+  }
+  return status;
+}
+
+// Answers the queries of a query file (see ReadQueries) in parallel, the
+// queries of largest predicted cost first so that no long one is left for
+// the end. Each result is written as soon as it is known, as one JSON
+// object per line (in completion order, "query" being the line index among
+// the queries). All the queries use the same seed, so the results do not
+// depend on the number of threads.
+int RunBatch(vector<string> &args, unordered_map<string, string> &options) {
+  if (RejectShard(options))
+    return -1;
+  Graph network(args[2]);
+  vector<Query> queries = ReadQueries(args[3]);
+  vector<string> method(args.begin() + 4, args.end());
+  uint64_t seed = ChooseSeed(options);
+  cerr << "Seed: " << seed << endl;
+  ThreadPool pool(ThreadsOption(options));
+
+  // every query is prepared first, to order them by cost (on one thread,
+  // the order does not matter and finding the cuts twice would)
+  int num_queries = queries.size();
+  bool predict = pool.NumThreads() > 1;
+  vector<unique_ptr<Graph>> graphs(num_queries);
+  vector<double> costs(num_queries, 0.0);
+  pool.ParallelFor(num_queries, [&](int i, int) {
+    graphs[i] = unique_ptr<Graph>(new Graph());
+    PrepareQuery(network, queries[i], *graphs[i]);
+    if (predict && graphs[i]->CountArcs() > 0)
+      costs[i] = SausageSolver(*graphs[i]).PredictCost();
+  });
+  vector<int> order(num_queries);
+  iota(order.begin(), order.end(), 0);
+  stable_sort(order.begin(), order.end(),
+              [&](int a, int b) { return costs[a] > costs[b]; });
+
+  vector<unique_ptr<ThreadPool>> inline_pools = pool.InlinePools();
+  mutex output;
+  atomic<int> failed(0);
+  pool.ParallelFor(num_queries, [&](int k, int thread_id) {
+    int i = order[k];
+    timeval start, end;
+    gettimeofday(&start, NULL);
+    MethodResult result;
+    string error = TrySolve(*graphs[i], method, options, seed,
+                            *inline_pools[thread_id], result);
+    gettimeofday(&end, NULL);
+    graphs[i].reset();
+
+    ostringstream line;
+    line.precision(10);
+    line << "{\"query\": " << i
+         << ", \"sources\": " << JsonString(queries[i].sources)
+         << ", \"targets\": " << JsonString(queries[i].targets);
+    if (!AddJsonResult(line, result, error, options))
+      failed++;
+    if (predict)
+      line << ", \"predicted_cost\": " << costs[i];
+    line << ", \"seconds\": " << Seconds(start, end) << "}\n";
+    lock_guard<mutex> lock(output);
+    cout << line.str() << flush;
+  });
+  return failed > 0 ? -1 : 0;
+}
+
+// Solves every entry of a manifest, one per line: network-file
+// sources-file targets-file (lines starting with # are skipped). The
+// entries are read and solved in parallel, in the order of the manifest,
+// each result being written as soon as it is known like by RunBatch
+// ("entry" being the line index among the entries).
+int RunManifest(vector<string> &args, unordered_map<string, string> &options) {
+  if (RejectShard(options))
+    return -1;
+  vector<vector<string>> entries;
+  ifstream in(args[2]);
+  string line;
+  while (getline(in, line)) {
+    stringstream fields(line);
+    vector<string> entry(3);
+    if ((fields >> entry[0] >> entry[1] >> entry[2]) && entry[0][0] != '#')
+      entries.push_back(entry);
+  }
+  vector<string> method(args.begin() + 3, args.end());
+  uint64_t seed = ChooseSeed(options);
+  cerr << "Seed: " << seed << endl;
+  ThreadPool pool(ThreadsOption(options));
+
+  vector<unique_ptr<ThreadPool>> inline_pools = pool.InlinePools();
+  mutex output;
+  atomic<int> failed(0);
+  pool.ParallelFor(entries.size(), [&](int i, int thread_id) {
+    vector<string> &entry = entries[i];
+    timeval start, end;
+    gettimeofday(&start, NULL);
+    MethodResult result;
+    string error;
+    if (!ifstream(entry[0])) {
+      error = "cannot read " + entry[0];
+    } else {
+      Graph graph(entry[0]);
+      graph.Preprocess(entry[1], entry[2], PRE_YES);
+      error = TrySolve(graph, method, options, seed, *inline_pools[thread_id],
+                       result);
+    }
+    gettimeofday(&end, NULL);
+
+    ostringstream line;
+    line.precision(10);
+    line << "{\"entry\": " << i << ", \"network\": " << JsonString(entry[0])
+         << ", \"sources\": " << JsonString(entry[1])
+         << ", \"targets\": " << JsonString(entry[2]);
+    if (!AddJsonResult(line, result, error, options))
+      failed++;
+    line << ", \"seconds\": " << Seconds(start, end) << "}\n";
+    lock_guard<mutex> lock(output);
+    cout << line.str() << flush;
+  });
+  return failed > 0 ? -1 : 0;
+}
+
+// Keeps the networks of args in memory and answers the queries sent on
+// --socket, else on stdin, see QueryServer.
+int Serve(vector<string> &args, unordered_map<string, string> &options) {
+  QueryServer server(ThreadsOption(options));
+  for (size_t i = 2; i < args.size(); i++) {
+    server.AddNetwork(args[i]);
+  }
+  if (!options.count("socket")) {
+    server.Serve(0, 1);
+    return 0;
+  }
+  server.Listen(options["socket"]);
+  cerr << "Cannot listen on " << options["socket"] << endl;
+  return -1;
+}
+
 int main(int argc, char **argv) {
-  if (argc < 5) {
+  vector<string> args;
+  unordered_map<string, string> options;
+  ParseArgs(vector<string>(argv, argv + argc), args, options);
+  int num_args = args.size();
+
+  if (num_args >= 2 && args[1] == "merge") {
+    vector<string> files(args.begin() + 2, args.end());
+    return MergeShards(files);
+  }
+  if (num_args >= 5 && args[1] == "index")
+    return BuildIndex(args, ChooseSeed(options));
+  if (num_args >= 5 && args[1] == "query")
+    return QueryIndex(args);
+  if (num_args >= 5 && args[1] == "queries")
+    return RunQueries(args, options);
+  if (num_args >= 5 && args[1] == "batch")
+    return RunBatch(args, options);
+  if (num_args >= 4 && args[1] == "manifest")
+    return RunManifest(args, options);
+  if (num_args >= 3 && args[1] == "serve")
+    return Serve(args, options);
+
+  if (num_args < 5) {
     // arg1: network file
     // arg2: sources file
     // arg3: targets file
-    // arg4: method (random, sausage, sampled)
+    // arg4: method (random, sausage, sampled, mc-bitparallel, mc-lazy,
+    //       sample-rss, sausage-hybrid)
+    // --epsilon: sampled methods stop once the 95% confidence interval is
+    //            narrower, num-iterations is then the cap (rare events
+    //            run to it, see RULE_OF_THREE)
+    // --probe timed: sample-fixed / sample-weighted time trial solves of the
+    //                probe candidates instead of predicting their cost
+    // --seed: seed of the random streams, the same seed gives the same
+    //         result (defaults to the current time)
+    // --threads: threads for the sampled methods (defaults to one per
+    //            core), the result does not depend on it
+    // --shard i/N: sampled methods only run the i-th of N slices of the
+    //              iterations (i from 0, needs --seed) and save their
+    //              statistics to --shard-file (shard-i-of-N.txt), to be
+    //              combined by: preach merge [shard-files...]
+    // Index of possible worlds, to answer many queries on one network:
+    //   preach index [network-file] [num-worlds] [index-file] [--seed seed]
+    //   preach query [index-file] [sources-file] [targets-file] ...
+    // Many queries on one network read once, one per line of query-file
+    // (comma separated sources, then targets):
+    //   preach queries [network-file] [query-file] [method] [...]
+    // The same in parallel, writing one JSON object per result:
+    //   preach batch [network-file] [query-file] [method] [...]
+    // Many small networks, one per line of manifest-file (network-file
+    // sources-file targets-file), in parallel like batch:
+    //   preach manifest [manifest-file] [method] [...]
+    // Server answering queries on networks kept in memory (see
+    // QueryServer.h for the protocol), on stdin / stdout or a socket:
+    //   preach serve [network-files...] [--socket path] [--threads count]
+    // --qmc replicates: sampled methods draw the edge states from randomly
+    //                   shifted lattice points, num-iterations being split
+    //                   into that many replicates
+    // --sparsify max-error: removes the edges of least impact on the
+    //                       probability first, lowering it by at most
+    //                       max-error (see Graph::Sparsify)
     cout << "Usage: preach [network-file] [sources-file] [targets-file] "
             "[method] [success-prob] [num-iterations] [probe-size] [probe-repeat]"
+            " [--epsilon width] [--probe timed] [--seed seed]"
+            " [--threads count] [--shard i/N [--shard-file file]]"
+            " [--qmc replicates] [--sparsify max-error]"
          << endl;
     return -1;
   }
 
-  string file_name = argv[1];
+  string file_name = args[1];
   Graph graph(file_name);
 
   int numNodes = graph.CountNodes();
@@ -34,47 +463,10 @@ int main(int argc, char **argv) {
        << " edges" << endl;
 
   // Read sources and targets and preprocess
-  graph.Preprocess(argv[2], argv[3], PRE_YES);
-
-  numNodes = graph.CountNodes();
-  numEdges = graph.CountArcs();
-  cout << endl
-       << "Modified graph size: " << numNodes << " nodes, " << numEdges
-       << " edges" << endl
-       << endl;
+  graph.Preprocess(args[2], args[3], PRE_YES);
 
-  if (numEdges == 0) {
-    // empty graph - source and target unreachable
-    cout << "0.0" << endl;
-    return 0;
-  }
-
-  unique_ptr<Solver> solver;
-  double prob;
-
-  string choice = argv[4];
-
-  if (choice == "random") {
-    solver = make_unique<RandomSolver>(graph);
-    prob = solver->Solve();
-  } else if (choice == "sausage") {
-    solver = make_unique<SausageSolver>(graph);
-    prob = solver->Solve();
-  } else {
-    double success_prob = atof(argv[5]);
-    int num_iteration = atoi(argv[6]), probe_size = 0, probe_repeat = 0;
-    bool fixed = false, weighted = false;
-    if (choice != "sample-random") {
-      fixed = true;
-      probe_size = atoi(argv[7]);
-      probe_repeat = atoi(argv[8]);
-      weighted = choice == "sample-weighted";
-    }
-    SamplingSolver sol(graph, num_iteration, success_prob, probe_size, probe_repeat, fixed, weighted);
-    prob = sol.Solve();
-  }
-
-  cout << "Reachability probability: " << prob;
-  cout << endl;
-  return 0;
-}
\ No newline at end of file
+  uint64_t seed = ChooseSeed(options);
+  ThreadPool pool(ThreadsOption(options));
+  vector<string> method(args.begin() + 4, args.end());
+  return SolveGraph(graph, method, options, seed, pool);
+}
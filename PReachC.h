@@ -0,0 +1,70 @@
+#ifndef PREACH_C_H
+#define PREACH_C_H
+
+/* C interface of PReachLib.h: the same handles behind opaque pointers.
+ * Functions taking a const handle may be called concurrently on it. No
+ * function throws: failures return NULL or -1. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct preach_network preach_network;
+typedef struct preach_query preach_query;
+
+typedef struct preach_options {
+  /* method and its parameters, as on the command line */
+  const char *method;
+  const char *const *params;
+  size_t num_params;
+  uint64_t seed;
+  /* threads of the sample-* methods, <= 0 for one per core */
+  int threads;
+  double epsilon;
+  int replicates;
+  int timed_probe;
+  double sparsify;
+} preach_options;
+
+typedef struct preach_result {
+  double probability;
+  /* sampled methods only */
+  double half_width;
+  long values;
+  double sparsify_error;
+  int nodes;
+  int edges;
+  double seconds;
+} preach_result;
+
+/* Edge i goes from sources[i] to targets[i] with probabilities[i]. */
+preach_network *preach_network_create(const char *const *sources,
+                                      const char *const *targets,
+                                      const double *probabilities,
+                                      size_t num_edges);
+preach_network *preach_network_read(const char *file_name);
+void preach_network_free(preach_network *network);
+
+preach_query *preach_query_create(const preach_network *network,
+                                  const char *const *sources,
+                                  size_t num_sources,
+                                  const char *const *targets,
+                                  size_t num_targets);
+void preach_query_free(preach_query *query);
+
+/* The defaults of PreachOptions: sausage, seed 1, one thread. */
+void preach_options_init(preach_options *options);
+
+/* Returns 0 and fills result, or -1 with the reason in error (at most
+ * error_size bytes, when error is not NULL). */
+int preach_solve(const preach_query *query, const preach_options *options,
+                 preach_result *result, char *error, size_t error_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,172 @@
+#include "PReachLib.h"
+#include "Method.h"
+#include "PReachC.h"
+#include "ThreadPool.h"
+#include <cstring>
+#include <sstream>
+
+PreachNetwork::PreachNetwork(const vector<PreachEdge> &edges) {
+  for (auto &edge : edges) {
+    graph_.AddEdge(edge.source, edge.target, edge.probability);
+  }
+  num_nodes_ = graph_.CountNodes();
+  num_edges_ = graph_.CountArcs();
+}
+
+PreachNetwork::PreachNetwork(const string &file_name) : graph_(file_name) {
+  num_nodes_ = graph_.CountNodes();
+  num_edges_ = graph_.CountArcs();
+}
+
+PreachQuery::PreachQuery(const PreachNetwork &network,
+                         const vector<string> &sources,
+                         const vector<string> &targets) {
+  graph_.CopyFrom(network.graph_, sources, targets);
+  graph_.Preprocess(sources, targets, PRE_YES);
+  num_nodes_ = graph_.CountNodes();
+  num_edges_ = graph_.CountArcs();
+}
+
+PreachResult PreachQuery::Solve(const PreachOptions &options) const {
+  timeval start, end;
+  gettimeofday(&start, NULL);
+  PreachResult answer;
+  // the solvers modify the graph they are given
+  Graph graph;
+  graph.CopyFrom(graph_);
+  if (options.sparsify > 0.0)
+    answer.sparsify_error = graph.Sparsify(options.sparsify);
+  answer.nodes = graph.CountNodes();
+  answer.edges = graph.CountArcs();
+
+  vector<string> method = {options.method};
+  method.insert(method.end(), options.params.begin(), options.params.end());
+  unordered_map<string, string> flags;
+  if (options.epsilon > 0.0) {
+    // to_string would round it to 6 decimals
+    ostringstream epsilon;
+    epsilon.precision(17);
+    epsilon << options.epsilon;
+    flags["epsilon"] = epsilon.str();
+  }
+  if (options.replicates > 0)
+    flags["qmc"] = to_string(options.replicates);
+  if (options.timed_probe)
+    flags["probe"] = "timed";
+  ThreadPool pool(options.threads);
+  MethodResult result;
+  answer.error = TrySolve(graph, method, flags, options.seed, pool, result);
+  answer.ok = answer.error.empty();
+  answer.probability = result.prob;
+  if (result.estimate.Count() > 0) {
+    answer.half_width = result.estimate.HalfWidth();
+    answer.values = result.estimate.Count();
+  }
+  gettimeofday(&end, NULL);
+  answer.seconds = Seconds(start, end);
+  return answer;
+}
+
+// The C handles are the C++ objects (built in place, a Graph does not
+// move).
+struct preach_network {
+  PreachNetwork network;
+  template <class Source>
+  preach_network(const Source &source) : network(source) {}
+};
+
+struct preach_query {
+  PreachQuery query;
+  preach_query(const PreachNetwork &network, const vector<string> &sources,
+               const vector<string> &targets)
+      : query(network, sources, targets) {}
+};
+
+preach_network *preach_network_create(const char *const *sources,
+                                      const char *const *targets,
+                                      const double *probabilities,
+                                      size_t num_edges) {
+  try {
+    vector<PreachEdge> edges;
+    for (size_t i = 0; i < num_edges; i++) {
+      edges.push_back({sources[i], targets[i], probabilities[i]});
+    }
+    return new preach_network(edges);
+  } catch (...) {
+    return NULL;
+  }
+}
+
+preach_network *preach_network_read(const char *file_name) {
+  try {
+    return new preach_network(string(file_name));
+  } catch (...) {
+    return NULL;
+  }
+}
+
+void preach_network_free(preach_network *network) { delete network; }
+
+preach_query *preach_query_create(const preach_network *network,
+                                  const char *const *sources,
+                                  size_t num_sources,
+                                  const char *const *targets,
+                                  size_t num_targets) {
+  try {
+    vector<string> source_names(sources, sources + num_sources);
+    vector<string> target_names(targets, targets + num_targets);
+    return new preach_query(network->network, source_names, target_names);
+  } catch (...) {
+    return NULL;
+  }
+}
+
+void preach_query_free(preach_query *query) { delete query; }
+
+void preach_options_init(preach_options *options) {
+  PreachOptions defaults;
+  options->method = "sausage";
+  options->params = NULL;
+  options->num_params = 0;
+  options->seed = defaults.seed;
+  options->threads = defaults.threads;
+  options->epsilon = defaults.epsilon;
+  options->replicates = defaults.replicates;
+  options->timed_probe = defaults.timed_probe;
+  options->sparsify = defaults.sparsify;
+}
+
+int preach_solve(const preach_query *query, const preach_options *options,
+                 preach_result *result, char *error, size_t error_size) {
+  PreachResult answer;
+  try {
+    PreachOptions cpp_options;
+    cpp_options.method = options->method;
+    cpp_options.params.assign(options->params,
+                              options->params + options->num_params);
+    cpp_options.seed = options->seed;
+    cpp_options.threads = options->threads;
+    cpp_options.epsilon = options->epsilon;
+    cpp_options.replicates = options->replicates;
+    cpp_options.timed_probe = options->timed_probe != 0;
+    cpp_options.sparsify = options->sparsify;
+    answer = query->query.Solve(cpp_options);
+  } catch (exception &e) {
+    answer.error = e.what();
+  }
+  if (!answer.ok) {
+    if (error != NULL && error_size > 0) {
+      strncpy(error, answer.error.c_str(), error_size - 1);
+      error[error_size - 1] = '\0';
+    }
+    return -1;
+  }
+  result->probability = answer.probability;
+  result->half_width = answer.half_width;
+  result->values = answer.values;
+  result->sparsify_error = answer.sparsify_error;
+  result->nodes = answer.nodes;
+  result->edges = answer.edges;
+  result->seconds = answer.seconds;
+  return 0;
+}
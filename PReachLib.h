@@ -0,0 +1,104 @@
+#ifndef PREACH_LIB_H
+#define PREACH_LIB_H
+
+#include "Graph.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Embeddable API of the command line methods, without files or processes
+// (see PReachC.h for the same in C). A PreachNetwork is built once and
+// only read afterwards, a PreachQuery is one sources / targets pair on it,
+// preprocessed once and solved any number of times. The const methods may
+// be called concurrently on the same objects: every solve works on its own
+// copy of the query's graph.
+
+// An edge of a network given in memory.
+struct PreachEdge {
+  string source;
+  string target;
+  double probability;
+};
+
+struct PreachOptions {
+  // Method and its positional parameters, as on the command line
+  // (sausage, sample-random 0.8 1000, mc-bitparallel 100000, ...).
+  string method = "sausage";
+  vector<string> params;
+
+  // The same seed gives the same result.
+  uint64_t seed = 1;
+
+  // Threads of the sample-* methods, <= 0 for one per core.
+  int threads = 1;
+
+  // As --epsilon, --qmc, --probe timed and --sparsify.
+  double epsilon = 0.0;
+  int replicates = 0;
+  bool timed_probe = false;
+  double sparsify = 0.0;
+};
+
+struct PreachResult {
+  // Whether the method ran, error saying why not otherwise.
+  bool ok = false;
+  string error;
+
+  double probability = 0.0;
+
+  // 95% confidence interval half width and number of values it is over,
+  // for the sampled methods only.
+  double half_width = 0.0;
+  long values = 0;
+
+  // The probability before sparsifying is at most this much higher.
+  double sparsify_error = 0.0;
+
+  // Size of the graph solved, after preprocessing (and sparsifying).
+  int nodes = 0;
+  int edges = 0;
+
+  double seconds = 0.0;
+};
+
+class PreachNetwork {
+public:
+  // Parallel edges after the first one are ignored, as in network files.
+  PreachNetwork(const vector<PreachEdge> &edges);
+
+  // Reads a network file (source target probability per line).
+  explicit PreachNetwork(const string &file_name);
+
+  int NumNodes() const { return num_nodes_; }
+  int NumEdges() const { return num_edges_; }
+
+private:
+  friend class PreachQuery;
+
+  Graph graph_;
+  int num_nodes_;
+  int num_edges_;
+};
+
+class PreachQuery {
+public:
+  // Copies the part of network between sources and targets and
+  // preprocesses it. network may be used by other queries meanwhile.
+  PreachQuery(const PreachNetwork &network, const vector<string> &sources,
+              const vector<string> &targets);
+
+  // Size after preprocessing.
+  int NumNodes() const { return num_nodes_; }
+  int NumEdges() const { return num_edges_; }
+
+  PreachResult Solve(const PreachOptions &options) const;
+
+private:
+  Graph graph_;
+  int num_nodes_;
+  int num_edges_;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "PReachC.h"
+#include "PReachLib.h"
+#include "gtest/gtest.h"
+#include <thread>
+
+namespace {
+// Two disjoint paths of two edges of 0.5 from a to d, and a b --> c edge
+// of 0.5 joining them. d is reached with 1 - (1 - 1/4)^2 = 7/16 without
+// it, and with 1/2 with it: 3/4 when a --> b is present (b and c are
+// reached), else 1/2 * 1/2.
+vector<PreachEdge> Diamond() {
+  return {{"a", "b", 0.5}, {"b", "d", 0.5}, {"a", "c", 0.5},
+          {"c", "d", 0.5}, {"b", "c", 0.5}};
+}
+const double DIAMOND_PROBABILITY = 0.5 * 7.0 / 16.0 + 0.5 * 0.5;
+
+TEST(PReachLibTest, ExactTest) {
+  PreachNetwork network(Diamond());
+  EXPECT_EQ(network.NumNodes(), 4);
+  EXPECT_EQ(network.NumEdges(), 5);
+  PreachQuery query(network, {"a"}, {"d"});
+  PreachResult result = query.Solve(PreachOptions());
+  ASSERT_TRUE(result.ok) << result.error;
+  EXPECT_NEAR(result.probability, DIAMOND_PROBABILITY, 1e-12);
+  EXPECT_EQ(result.values, 0);
+
+  // unknown names and unreachable targets
+  PreachResult none = PreachQuery(network, {"d"}, {"a", "x"}).Solve({});
+  ASSERT_TRUE(none.ok);
+  EXPECT_EQ(none.probability, 0.0);
+
+  PreachOptions invalid;
+  invalid.method = "sample-random";
+  EXPECT_FALSE(query.Solve(invalid).ok);
+}
+
+TEST(PReachLibTest, ZeroProbabilityTest) {
+  // arcs of probability 0, or too small for 1 - p to differ from 1, are
+  // never present in the lazily sampled worlds
+  vector<PreachEdge> edges = Diamond();
+  edges.push_back({"a", "d", 0.0});
+  edges.push_back({"c", "b", 1e-20});
+  PreachNetwork network(edges);
+  PreachQuery query(network, {"a"}, {"d"});
+  PreachOptions options;
+  options.method = "mc-lazy";
+  options.params = {"100000"};
+  PreachResult result = query.Solve(options);
+  ASSERT_TRUE(result.ok) << result.error;
+  EXPECT_NEAR(result.probability, DIAMOND_PROBABILITY, 0.01);
+}
+
+TEST(PReachLibTest, ConcurrentTest) {
+  // queries and solves running at once on one network give the results
+  // of single ones
+  PreachNetwork network(Diamond());
+  PreachQuery shared(network, {"a"}, {"d"});
+  PreachOptions options;
+  options.method = "sample-random";
+  options.params = {"0.8", "2000"};
+  options.seed = 7;
+  PreachResult expected = shared.Solve(options);
+  ASSERT_TRUE(expected.ok) << expected.error;
+  EXPECT_EQ(expected.values, 2000);
+  EXPECT_NEAR(expected.probability, DIAMOND_PROBABILITY,
+              2 * expected.half_width);
+
+  vector<PreachResult> sampled(4), exact(4);
+  vector<thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&, i] {
+      sampled[i] = shared.Solve(options);
+      exact[i] = PreachQuery(network, {"a"}, {"d"}).Solve({});
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(sampled[i].probability, expected.probability);
+    EXPECT_NEAR(exact[i].probability, DIAMOND_PROBABILITY, 1e-12);
+  }
+}
+
+TEST(PReachLibTest, CTest) {
+  const char *sources[] = {"a", "b", "a", "c", "b"};
+  const char *targets[] = {"b", "d", "c", "d", "c"};
+  const double probabilities[] = {0.5, 0.5, 0.5, 0.5, 0.5};
+  preach_network *network =
+      preach_network_create(sources, targets, probabilities, 5);
+  ASSERT_NE(network, nullptr);
+  const char *from[] = {"a"}, *to[] = {"d"};
+  preach_query *query = preach_query_create(network, from, 1, to, 1);
+  ASSERT_NE(query, nullptr);
+
+  preach_options options;
+  preach_options_init(&options);
+  preach_result result;
+  char error[256];
+  ASSERT_EQ(preach_solve(query, &options, &result, error, sizeof(error)), 0);
+  EXPECT_NEAR(result.probability, DIAMOND_PROBABILITY, 1e-12);
+
+  const char *params[] = {"many"};
+  options.method = "mc-bitparallel";
+  options.params = params;
+  options.num_params = 1;
+  EXPECT_EQ(preach_solve(query, &options, &result, error, sizeof(error)), -1);
+  EXPECT_NE(string(error).find("invalid"), string::npos);
+
+  preach_query_free(query);
+  preach_network_free(network);
+}
+} // namespace
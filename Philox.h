@@ -0,0 +1,71 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cstdint>
+
+using namespace std;
+
+typedef array<uint32_t, 4> PhiloxCounter;
+typedef array<uint32_t, 2> PhiloxKey;
+
+// Counter-based random numbers (Philox4x32-10, Salmon et al. 2011): the
+// output is a keyed bijection of a 128 bit counter, so any (seed, stream)
+// pair gives an independent stream without any state to share or to
+// advance. Solvers use one stream per iteration, which makes a run depend
+// only on the seed, whatever the order the iterations are computed in.
+class Philox {
+public:
+  typedef uint32_t result_type;
+
+  // The seed is the key. The stream takes the upper half of the counter,
+  // the position in the stream the lower half.
+  Philox(uint64_t seed = 0, uint64_t stream = 0)
+      : key_{{uint32_t(seed), uint32_t(seed >> 32)}},
+        counter_{{0, 0, uint32_t(stream), uint32_t(stream >> 32)}} {}
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return UINT32_MAX; }
+
+  result_type operator()() {
+    if (index_ == 4) {
+      output_ = Block(counter_, key_);
+      index_ = 0;
+      if (++counter_[0] == 0)
+        ++counter_[1];
+    }
+    return output_[index_++];
+  }
+
+  uint64_t Next64() {
+    uint64_t low = (*this)();
+    return low | uint64_t((*this)()) << 32;
+  }
+
+  // Uniform in [0, 1), with 53 random bits.
+  double NextDouble() { return (Next64() >> 11) * (1.0 / 9007199254740992.0); }
+
+  // The 10 rounds of Philox4x32 on one counter value.
+  static PhiloxCounter Block(PhiloxCounter counter, PhiloxKey key) {
+    for (int round = 0; round < 10; round++) {
+      uint64_t product0 = uint64_t(0xD2511F53) * counter[0];
+      uint64_t product1 = uint64_t(0xCD9E8D57) * counter[2];
+      counter = {{uint32_t(product1 >> 32) ^ counter[1] ^ key[0],
+                  uint32_t(product1),
+                  uint32_t(product0 >> 32) ^ counter[3] ^ key[1],
+                  uint32_t(product0)}};
+      key[0] += 0x9E3779B9;
+      key[1] += 0xBB67AE85;
+    }
+    return counter;
+  }
+
+private:
+  PhiloxKey key_;
+  PhiloxCounter counter_;
+  PhiloxCounter output_;
+  // Next unused word of output_, 4 when a new block is needed.
+  int index_ = 4;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "Philox.h"
+#include "gtest/gtest.h"
+
+namespace {
+// Known answers of the reference implementation (Random123).
+TEST(PhiloxTest, KnownAnswerTest) {
+  PhiloxCounter zeros = Philox::Block({{0, 0, 0, 0}}, {{0, 0}});
+  EXPECT_EQ(zeros, PhiloxCounter({{0x6627e8d5, 0xe169c58d, 0xbc57ac4c,
+                                   0x9b00dbd8}}));
+
+  PhiloxCounter ones = Philox::Block(
+      {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}},
+      {{0xffffffff, 0xffffffff}});
+  EXPECT_EQ(ones, PhiloxCounter({{0x408f276d, 0x41c83b0e, 0xa20bc7c6,
+                                  0x6d5451fd}}));
+
+  PhiloxCounter pi = Philox::Block(
+      {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+      {{0xa4093822, 0x299f31d0}});
+  EXPECT_EQ(pi, PhiloxCounter({{0xd16cfe09, 0x94fdcceb, 0x5001e420,
+                                0x24126ea1}}));
+}
+
+TEST(PhiloxTest, StreamTest) {
+  // the same (seed, stream) replays the same numbers
+  Philox first(42, 7), again(42, 7), other(42, 8);
+  bool differs = false;
+  for (int i = 0; i < 10; i++) {
+    uint32_t x = first();
+    EXPECT_EQ(x, again());
+    differs = differs || x != other();
+  }
+  EXPECT_TRUE(differs);
+
+  // words come from consecutive counters of the stream
+  Philox stream(42, 7);
+  PhiloxCounter block = Philox::Block({{1, 0, 7, 0}}, {{42, 0}});
+  for (int i = 0; i < 4; i++)
+    stream();
+  for (int i = 0; i < 4; i++)
+    EXPECT_EQ(stream(), block[i]);
+}
+} // namespace
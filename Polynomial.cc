@@ -7,11 +7,15 @@ void Polynomial::AddEdge(int edge_index, double p) {
     // Multiply by X term
     Term xTerm = term;
     xTerm.Multiply(edge_index, p, false);
-    new_terms.push_back(xTerm);
     // Multiply by Y term
     Term yTerm = term;
     yTerm.Multiply(edge_index, p, true);
-    new_terms.push_back(yTerm);
+    // a certain (or impossible) edge gives a term with no weight: drop it,
+    // otherwise every certain edge of a sample doubles the terms for nothing
+    if (xTerm.GetCoefficient() > 0.0)
+      new_terms.push_back(xTerm);
+    if (yTerm.GetCoefficient() > 0.0)
+      new_terms.push_back(yTerm);
   }
   // swap newTerms with terms
   new_terms.swap(terms_);
@@ -48,19 +52,15 @@ void Polynomial::Collapse(Edges &mid_edges, Nodes &end_nodes,
 }
 
 double Polynomial::GetResult() {
-  // SANITY CHECKS
-  //assert(terms_.size() == 2);
-  double totalCoeff =
-      terms_.front().GetCoefficient() + terms_.back().GetCoefficient();
- // assert(totalCoeff < 1.01 && totalCoeff > 0.99);
-
-  if (terms_.front().HasReachableNodes()) {
-    //assert(!terms_.back().HasReachableNodes());
-    return terms_.front().GetCoefficient();
-  } else {
-    //assert(terms_.back().HasReachableNodes());
-    return terms_.back().GetCoefficient();
+  // Terms with no weight are dropped, so the reaching and the non-reaching
+  // term may not both be there.
+  double result = 0.0;
+  for (auto &term : terms_) {
+    if (term.HasReachableNodes()) {
+      result += term.GetCoefficient();
+    }
   }
+  return result;
 }
 
 // Advances the polynomial: prepares it for the next cut.
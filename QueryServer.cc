@@ -0,0 +1,177 @@
+#include "QueryServer.h"
+#include <csignal>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+QueryServer::Connection::~Connection() {
+  if (owned)
+    close(out_fd);
+}
+
+QueryServer::QueryServer(int num_workers) {
+  if (num_workers <= 0)
+    num_workers = max(1u, thread::hardware_concurrency());
+  for (int i = 0; i < num_workers; i++) {
+    workers_.emplace_back(&QueryServer::WorkerLoop, this);
+  }
+}
+
+QueryServer::~QueryServer() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stop_ = true;
+  }
+  ready_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void QueryServer::AddNetwork(const string &file_name) {
+  networks_[file_name] = unique_ptr<Graph>(new Graph(file_name));
+}
+
+void QueryServer::Serve(int in_fd, int out_fd) {
+  ReadRequests(in_fd, make_shared<Connection>(out_fd, false));
+  unique_lock<mutex> lock(mutex_);
+  done_.wait(lock, [this] { return queue_.empty() && busy_ == 0; });
+}
+
+bool QueryServer::Listen(const string &path) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+    return false;
+  path.copy(address.sun_path, path.size());
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(path.c_str());
+  if (listener < 0 ||
+      bind(listener, (sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(listener, SOMAXCONN) != 0)
+    return false;
+  // a client gone before its answers must not take the server down
+  signal(SIGPIPE, SIG_IGN);
+  while (true) {
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0)
+      continue;
+    // the reader thread keeps the connection open until the client is done
+    // sending, the last answer closes it
+    thread(&QueryServer::ReadRequests, this, fd,
+           make_shared<Connection>(fd, true))
+        .detach();
+  }
+}
+
+void QueryServer::ReadRequests(int in_fd, shared_ptr<Connection> connection) {
+  string pending;
+  char buffer[1 << 16];
+  ssize_t size;
+  while ((size = read(in_fd, buffer, sizeof(buffer))) > 0) {
+    pending.append(buffer, size);
+    size_t begin = 0, end;
+    while ((end = pending.find('\n', begin)) != string::npos) {
+      Request request{pending.substr(begin, end - begin), connection, {}};
+      gettimeofday(&request.received, NULL);
+      begin = end + 1;
+      {
+        lock_guard<mutex> lock(mutex_);
+        queue_.push_back(move(request));
+      }
+      ready_.notify_one();
+    }
+    pending.erase(0, begin);
+  }
+}
+
+void QueryServer::WorkerLoop() {
+  // requests are spread over the workers, each runs its methods alone
+  ThreadPool pool(1);
+  while (true) {
+    Request request;
+    {
+      unique_lock<mutex> lock(mutex_);
+      ready_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (stop_)
+        return;
+      request = move(queue_.front());
+      queue_.pop_front();
+      busy_++;
+    }
+
+    stringstream in(request.line);
+    vector<string> fields;
+    string field;
+    while (in >> field) {
+      fields.push_back(field);
+    }
+    if (!fields.empty()) {
+      timeval start;
+      gettimeofday(&start, NULL);
+      string answer = fields[0] + " " +
+                      Answer(fields, Seconds(request.received, start), pool) +
+                      "\n";
+      Connection &connection = *request.connection;
+      lock_guard<mutex> lock(connection.lock);
+      for (size_t written = 0; written < answer.size();) {
+        ssize_t size = write(connection.out_fd, answer.data() + written,
+                             answer.size() - written);
+        if (size <= 0)
+          break;
+        written += size;
+      }
+    }
+    request.connection.reset();
+
+    {
+      lock_guard<mutex> lock(mutex_);
+      busy_--;
+    }
+    done_.notify_all();
+  }
+}
+
+string QueryServer::Answer(vector<string> &fields, double wait,
+                           ThreadPool &pool) {
+  vector<string> args;
+  unordered_map<string, string> options;
+  ParseArgs(fields, args, options);
+  if (args.size() < 5)
+    return "error expected {id} {network} {sources} {targets} {method}";
+  auto network = networks_.find(args[1]);
+  if (network == networks_.end())
+    return "error unknown network " + args[1];
+  if (options.count("shard"))
+    return "error --shard runs on the command line only";
+
+  timeval start, end;
+  gettimeofday(&start, NULL);
+  MethodResult result;
+  try {
+    vector<string> sources = Graph::SplitNames(args[2]);
+    vector<string> targets = Graph::SplitNames(args[3]);
+    Graph graph;
+    graph.CopyFrom(*network->second, sources, targets);
+    graph.Preprocess(sources, targets, PRE_YES);
+    vector<string> method(args.begin() + 4, args.end());
+    string error =
+        TrySolve(graph, method, options, ChooseSeed(options), pool, result);
+    if (!error.empty())
+      return "error " + error;
+  } catch (exception &e) {
+    return string("error invalid parameters: ") + e.what();
+  }
+  gettimeofday(&end, NULL);
+
+  ostringstream answer;
+  answer.precision(10);
+  Accumulator &estimate = result.estimate;
+  answer << "ok " << result.prob << " "
+         << (estimate.Count() > 0 ? estimate.HalfWidth() : 0.0) << " "
+         << estimate.Count() << " " << wait << " " << Seconds(start, end);
+  if (options.count("sparsify"))
+    answer << " " << result.sparsify_error;
+  return answer.str();
+}
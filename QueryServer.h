@@ -0,0 +1,91 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#include "Graph.h"
+#include "Method.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/time.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Answers queries on networks kept in memory, over a line protocol. Each
+// request line
+//   {id} {network} {sources} {targets} {method} [params...] [--name value]
+// is answered, in the order the requests complete, by a line
+//   {id} ok {probability} {half-width} {values} {wait-seconds} {seconds}
+// (followed by {sparsify-error} with --sparsify) or
+//   {id} error {message}
+// network is one of the network files loaded at startup, sources and
+// targets are comma separated node names, method, params and options are
+// as on the command line. half-width is the one of the 95% confidence
+// interval over values iterations (0 0 for the exact methods), wait-seconds
+// the time spent queued and seconds the time spent answering. The
+// probability before --sparsify is at most sparsify-error higher. Requests
+// run on a pool of worker threads, each on its own copy of the part of the
+// network it needs.
+class QueryServer {
+public:
+  // num_workers <= 0 means one worker per core.
+  QueryServer(int num_workers);
+  ~QueryServer();
+
+  QueryServer(const QueryServer &) = delete;
+  QueryServer &operator=(const QueryServer &) = delete;
+
+  // Loads a network, named by file_name in the requests.
+  void AddNetwork(const string &file_name);
+
+  // Serves the requests read from in_fd, answering on out_fd, until in_fd
+  // ends and all of them are answered.
+  void Serve(int in_fd, int out_fd);
+
+  // Serves every connection to a Unix domain socket at path, like Serve().
+  // Only returns, false, if the socket cannot be set up.
+  bool Listen(const string &path);
+
+private:
+  // Where the answers of a requests stream go, closed once the stream has
+  // ended and all of its requests are answered.
+  struct Connection {
+    int out_fd;
+    bool owned;
+    mutex lock;
+    Connection(int fd, bool owns_fd) : out_fd(fd), owned(owns_fd) {}
+    ~Connection();
+  };
+
+  struct Request {
+    string line;
+    shared_ptr<Connection> connection;
+    timeval received;
+  };
+
+  unordered_map<string, unique_ptr<Graph>> networks_;
+
+  vector<thread> workers_;
+  mutex mutex_;
+  condition_variable ready_;
+  condition_variable done_;
+  deque<Request> queue_;
+  // Requests taken by a worker and not answered yet, guarded by mutex_.
+  int busy_ = 0;
+  bool stop_ = false;
+
+  void WorkerLoop();
+
+  // Queues every line read from in_fd until it ends.
+  void ReadRequests(int in_fd, shared_ptr<Connection> connection);
+
+  // The answer line of a request, without its id, pool running the
+  // sampled methods.
+  string Answer(vector<string> &fields, double wait, ThreadPool &pool);
+};
+
+#endif
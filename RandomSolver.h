@@ -1,16 +1,17 @@
 #ifndef RANDOM_SOLVER_H
 #define RANDOM_SOLVER_H
 
+#include "Philox.h"
 #include "Solver.h"
 #include <algorithm>
-#include <ctime>
 #include <numeric>
 
 class RandomSolver : public Solver {
   vector<int> shuffled_edges_;
+  uint64_t seed_;
 
 public:
-  RandomSolver(Graph &graph) : Solver(graph) {}
+  RandomSolver(Graph &graph, uint64_t seed) : Solver(graph), seed_(seed) {}
 
   double Solve() {
     Shuffle();
@@ -29,8 +30,8 @@ public:
 private:
   void Shuffle() {
     FOREACH_BS(edge_id, all_edges_) { shuffled_edges_.push_back(edge_id); }
-    srand(time(0));
-    random_shuffle(shuffled_edges_.begin(), shuffled_edges_.end());
+    Philox rng(seed_);
+    shuffle(shuffled_edges_.begin(), shuffled_edges_.end(), rng);
   }
 };
 
@@ -0,0 +1,130 @@
+#include "RssSolver.h"
+#include <cmath>
+
+RssSolver::RssSolver(Graph &graph, int num_samples, int num_strata_edges,
+                     int threshold, uint64_t seed)
+    : Solver(graph), num_samples_(num_samples),
+      num_strata_edges_(num_strata_edges), threshold_(threshold),
+      out_arcs_(NUM_NODES), seed_(seed) {
+  source_node_ = source_._Find_first();
+  sink_node_ = target_._Find_first();
+  FOREACH_BS(edge_id, all_edges_) {
+    out_arcs_[edge_info_[edge_id].edge_terminals.first].emplace_back(
+        edge_id, edge_info_[edge_id].edge_terminals.second);
+  }
+
+  Edges ranked;
+  vector<Cut> cuts = graph.FindSomeGoodCuts();
+  int id = 0;
+  for (auto &cut : cuts) {
+    EdgeSubset subset(id++, cut, out_arcs_, edge_info_);
+    Edges edges = subset.GetEdges() & ~ranked;
+    FOREACH_BS(edge_id, edges) { ranked_edges_.push_back(edge_id); }
+    ranked |= edges;
+  }
+  Edges others = all_edges_ & ~ranked;
+  FOREACH_BS(edge_id, others) { ranked_edges_.push_back(edge_id); }
+}
+
+double RssSolver::Solve() {
+  num_leaves_ = 0;
+  // certain edges (e.g. from SOURCE and to SINK) are never stratified
+  Edges present;
+  Edges absent;
+  FOREACH_BS(edge_id, all_edges_) {
+    if (edge_info_[edge_id].p >= 1.0)
+      present.set(edge_id);
+    else if (edge_info_[edge_id].p <= 0.0)
+      absent.set(edge_id);
+  }
+  return Estimate(present, absent, num_samples_);
+}
+
+double RssSolver::Estimate(Edges &present, Edges &absent, double budget) {
+  Nodes reached = Reachable(present);
+  if (reached[sink_node_])
+    return 1.0;
+  if (!Reachable(all_edges_ & ~absent)[sink_node_])
+    return 0.0;
+  if (budget < threshold_)
+    return MonteCarlo(present, absent, (int)ceil(budget));
+
+  // pick the undetermined edges leaving the surely reached nodes, the
+  // state of any other edge cannot extend what is reached yet
+  vector<int> picked;
+  for (size_t i = 0; i < ranked_edges_.size() &&
+                     (int)picked.size() < num_strata_edges_;
+       i++) {
+    int edge_id = ranked_edges_[i];
+    pair<int, int> &terminals = edge_info_[edge_id].edge_terminals;
+    if (!present[edge_id] && !absent[edge_id] && reached[terminals.first] &&
+        !reached[terminals.second])
+      picked.push_back(edge_id);
+  }
+  if (picked.empty())
+    return MonteCarlo(present, absent, (int)ceil(budget));
+
+  double result = 0.0;
+  double none_present = 1.0;
+  Edges stratum_absent = absent;
+  for (int edge_id : picked) {
+    double stratum_prob = none_present * edge_info_[edge_id].p;
+    if (stratum_prob > 0.0) {
+      Edges stratum_present = present;
+      stratum_present.set(edge_id);
+      result += stratum_prob * Estimate(stratum_present, stratum_absent,
+                                        budget * stratum_prob);
+    }
+    none_present *= 1.0 - edge_info_[edge_id].p;
+    stratum_absent.set(edge_id);
+  }
+  if (none_present > 0.0) {
+    result += none_present *
+              Estimate(present, stratum_absent, budget * none_present);
+  }
+  return result;
+}
+
+double RssSolver::MonteCarlo(Edges &present, Edges &absent, int num_samples) {
+  rng_ = Philox(seed_, num_leaves_++);
+  int reaching = 0;
+  for (int i = 0; i < num_samples; i++) {
+    Nodes visited;
+    visited.set(source_node_);
+    stack_.assign(1, source_node_);
+    while (!stack_.empty()) {
+      int node = stack_.back();
+      stack_.pop_back();
+      for (auto &arc : out_arcs_[node]) {
+        if (visited[arc.second] || absent[arc.first])
+          continue;
+        if (!present[arc.first] && NextRand() >= edge_info_[arc.first].p)
+          continue;
+        visited.set(arc.second);
+        stack_.push_back(arc.second);
+      }
+      if (visited[sink_node_]) {
+        reaching++;
+        break;
+      }
+    }
+  }
+  return double(reaching) / double(num_samples);
+}
+
+Nodes RssSolver::Reachable(const Edges &arcs) {
+  Nodes visited;
+  visited.set(source_node_);
+  stack_.assign(1, source_node_);
+  while (!stack_.empty()) {
+    int node = stack_.back();
+    stack_.pop_back();
+    for (auto &arc : out_arcs_[node]) {
+      if (arcs[arc.first] && !visited[arc.second]) {
+        visited.set(arc.second);
+        stack_.push_back(arc.second);
+      }
+    }
+  }
+  return visited;
+}
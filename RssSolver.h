@@ -0,0 +1,70 @@
+#ifndef RSS_SOLVER_H
+#define RSS_SOLVER_H
+
+#include "EdgeSubset.h"
+#include "Graph.h"
+#include "Philox.h"
+#include "Solver.h"
+#include "Util.h"
+#include <vector>
+
+// Recursive stratified sampling. A few undetermined edges leaving the nodes
+// surely reached from SOURCE are picked and their states split the sample
+// space into strata with exact probabilities: stratum i has the first i
+// picked edges absent and the next one present, the last stratum has all
+// of them absent. The sample
+// budget is shared proportionally to the stratum probabilities and each
+// stratum is estimated recursively, down to plain Monte Carlo once its
+// budget is below the threshold. Strata whose forced edges already decide
+// reachability are exact and cost no samples.
+class RssSolver : public Solver {
+public:
+  RssSolver(Graph &graph, int num_samples, int num_strata_edges,
+            int threshold, uint64_t seed);
+
+  double Solve();
+
+private:
+  int num_samples_;
+
+  // Number of edges picked at each level of the recursion.
+  int num_strata_edges_;
+
+  // Strata with a smaller budget are estimated by plain Monte Carlo.
+  int threshold_;
+
+  // Edges by priority for stratification: the left to middle edges of the
+  // good cuts from SOURCE to SINK, then the others.
+  vector<int> ranked_edges_;
+
+  // Out-arcs (arc id, target node id) of every node, indexed by node id.
+  OutArcs out_arcs_;
+
+  int source_node_;
+  int sink_node_;
+
+  uint64_t seed_;
+
+  // Each Monte Carlo leaf of the recursion draws from its own stream,
+  // numbered in the order the leaves are visited.
+  uint64_t num_leaves_ = 0;
+  Philox rng_;
+
+  vector<int> stack_;
+
+  double NextRand() { return rng_.NextDouble(); }
+
+  // Estimates the probability of reaching SINK given the forced edge
+  // states, with the given sample budget. Falls back to Monte Carlo when
+  // no edge is left to stratify on.
+  double Estimate(Edges &present, Edges &absent, double budget);
+
+  // Plain Monte Carlo given the forced edge states, the other edges are
+  // drawn lazily during the traversal.
+  double MonteCarlo(Edges &present, Edges &absent, int num_samples);
+
+  // Returns the nodes reachable from SOURCE using only the given arcs.
+  Nodes Reachable(const Edges &arcs);
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include "Philox.h"
+#include "Util.h"
+#include <cstdint>
+#include <functional>
+
+// A sampled assignment of edge states, as two dense edge sets. Edges in
+// neither set are not sampled and keep their probability.
+struct Sample {
+  Edges present; // edges forced to be present
+  Edges absent;  // edges forced to be absent
+
+  Edges Sampled() const { return present | absent; }
+
+  bool operator==(const Sample &other) const {
+    return present == other.present && absent == other.absent;
+  }
+};
+
+struct SampleHash {
+  size_t operator()(const Sample &sample) const {
+    std::hash<Edges> hasher;
+    return hasher(sample.present) * 31 + hasher(sample.absent);
+  }
+};
+
+// Scales a probability to a threshold for uniform 32 bit draws: a draw
+// below the threshold happens with probability p.
+inline uint64_t ProbabilityThreshold(double p) {
+  if (p <= 0.0)
+    return 0;
+  if (p >= 1.0)
+    return 1ull << 32;
+  return (uint64_t)(p * 4294967296.0);
+}
+
+// Returns NUM_LANES independent bits, each set with probability
+// threshold / 2^32. Uses one random word per bit of the threshold,
+// walking from its least to its most significant set bit: each step either
+// ORs (bit 1) or ANDs (bit 0) a fresh random word, halving the probability
+// accumulated so far and adding one half for a set bit.
+inline Lanes SampleLanes(Philox &rng, uint64_t threshold) {
+  if (threshold >= (1ull << 32))
+    return ~Lanes(0);
+  if (threshold == 0)
+    return 0;
+  Lanes lanes = 0;
+  for (int bit = __builtin_ctzll(threshold); bit < 32; bit++) {
+    if ((threshold >> bit) & 1)
+      lanes |= rng.Next64();
+    else
+      lanes &= rng.Next64();
+  }
+  return lanes;
+}
+
+#endif
@@ -0,0 +1,40 @@
+#include "SampleBatch.h"
+
+SampleBatch::SampleBatch(Graph &graph) : bfs_(graph.GetOutArcs()) {
+  sources_.push_back(graph.GetNodeBitset(SOURCE)._Find_first());
+  sink_node_ = graph.GetNodeBitset(SINK)._Find_first();
+  unordered_map<int, EdgeInfo> edge_info;
+  graph.GetEdgeInfo(edge_info);
+  int num_arc_ids = graph.GetInnerG().maxArcId() + 1;
+  base_possible_.assign(num_arc_ids, 0);
+  base_certain_.assign(num_arc_ids, 0);
+  for (auto &info : edge_info) {
+    if (info.second.p > 0.0)
+      base_possible_[info.first] = ~Lanes(0);
+    if (info.second.p >= 1.0)
+      base_certain_[info.first] = ~Lanes(0);
+  }
+}
+
+void SampleBatch::Clear() {
+  // same sizes, so these assignments reuse the existing storage
+  possible_ = base_possible_;
+  certain_ = base_certain_;
+  count_ = 0;
+}
+
+void SampleBatch::Add(const Sample &sample) {
+  Lanes bit = Lanes(1) << count_++;
+  FOREACH_BS(arc, sample.absent) { possible_[arc] &= ~bit; }
+  FOREACH_BS(arc, sample.present) { certain_[arc] |= bit; }
+}
+
+void SampleBatch::Classify(Lanes &never, Lanes &always) {
+  Lanes used = count_ == NUM_LANES ? ~Lanes(0) : (Lanes(1) << count_) - 1;
+  never = used & ~Reach(possible_);
+  always = used & Reach(certain_);
+}
+
+Lanes SampleBatch::Reach(const vector<Lanes> &arc_lanes) {
+  return bfs_.Reach(arc_lanes.data(), sources_, sink_node_)[sink_node_];
+}
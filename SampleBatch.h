@@ -0,0 +1,56 @@
+#ifndef SAMPLE_BATCH_H
+#define SAMPLE_BATCH_H
+
+#include "CutUtil.h"
+#include "Graph.h"
+#include "LaneBfs.h"
+#include "Sample.h"
+#include "Util.h"
+#include <vector>
+
+using namespace std;
+
+// Sorts out up to NUM_LANES samples of a graph at once, one sample per bit
+// lane, by two word-parallel traversals of the base arcs: a sample is
+// trivially 0 when SINK is not reached even through all the arcs that may
+// be present, trivially 1 when it is reached through the certain ones
+// (present in the sample or of weight 1). Only the other samples need an
+// exact solve.
+class SampleBatch {
+public:
+  SampleBatch() = default;
+  SampleBatch(Graph &graph);
+
+  // Starts a new batch.
+  void Clear();
+
+  // Puts sample in the next lane, at most NUM_LANES per batch.
+  void Add(const Sample &sample);
+
+  // Bit i of never (always) is set when the i-th sample added trivially
+  // gives 0 (1).
+  void Classify(Lanes &never, Lanes &always);
+
+private:
+  vector<int> sources_;
+  int sink_node_;
+
+  // Lanes in which each arc, by id, may be present and is certainly
+  // present, before the samples are applied.
+  vector<Lanes> base_possible_;
+  vector<Lanes> base_certain_;
+
+  // Lanes of the current batch.
+  int count_ = 0;
+  vector<Lanes> possible_;
+  vector<Lanes> certain_;
+
+  // Over the arcs by id.
+  LaneBfs bfs_;
+
+  // Lanes in which SINK is reached from SOURCE through the arcs present
+  // in arc_lanes.
+  Lanes Reach(const vector<Lanes> &arc_lanes);
+};
+
+#endif
@@ -1,73 +1,342 @@
 #include "SamplingSolver.h"
 
 double SamplingSolver::Solve() {
-  double result = 0.0;
+  estimate_ = Accumulator();
+  // the last iteration of a previous Solve() left its lattice point behind
+  lattice_point_ = -1;
+  lattice_replicate_ = -1;
   Edges sample_edges;
   if (fixed_) {
     sample_edges = Probe();
   }
-  for (int i = 0; i < num_iteration_; i++) {
-    Graph graph;
-    graph.CopyFrom(graph_);
+  SampleCache cache;
+  cache_ = fixed_ ? &cache : nullptr;
+  if (replicates_ > 0) {
+    // as many dimensions as draws per sample
+    int dims = fixed_ ? sample_edges.count() : 2 * edge_ids_.size();
+    lattice_ = Lattice(replicate_points_, dims);
+  }
+
+  // Every thread but the first works on its own copy of this solver (view,
+  // random stream and scratch space). The iterations are computed by
+  // blocks, then added up in iteration order: as iteration i only depends
+  // on stream i, the result and the early stop do not depend on the number
+  // of threads.
+  int num_threads = pool_ ? pool_->NumThreads() : 1;
+  vector<SamplingSolver> workers(num_threads - 1, *this);
+  auto worker = [&](int thread_id) -> SamplingSolver & {
+    return thread_id == 0 ? *this : workers[thread_id - 1];
+  };
+  int block_size = ITERATION_BLOCK * num_threads;
+  vector<Iteration> iterations(block_size);
+  vector<int> unsolved;
+  double replicate_sum = 0.0;
+  int replicate_count = 0;
+  for (int first = 0; first < num_iteration_; first += block_size) {
+    int count = min(block_size, num_iteration_ - first);
+    int num_batches = (count + NUM_LANES - 1) / NUM_LANES;
+    RunParallel(num_batches, [&](int batch, int thread_id) {
+      int offset = batch * NUM_LANES;
+      worker(thread_id).DrawBatch(first_iteration_ + first + offset,
+                                  min(NUM_LANES, count - offset),
+                                  sample_edges, &iterations[offset]);
+    });
+    // only the samples left need the exact solver
+    unsolved.clear();
+    for (int i = 0; i < count; i++) {
+      if (!iterations[i].solved)
+        unsolved.push_back(i);
+    }
+    RunParallel(unsolved.size(), [&](int i, int thread_id) {
+      Iteration &iteration = iterations[unsolved[i]];
+      iteration.value =
+          iteration.weight * worker(thread_id).SolveCached(iteration.sample);
+    });
 
-    //graph.Print();
+    for (int i = 0; i < count; i++) {
+      double value = iterations[i].value;
+      if (replicates_ > 0) {
+        replicate_sum += value;
+        if (++replicate_count == replicate_points_) {
+          estimate_.Add(replicate_sum / replicate_points_);
+          replicate_sum = 0.0;
+          replicate_count = 0;
+        }
+        continue;
+      }
+      estimate_.Add(value);
+      if (epsilon_ > 0.0 && estimate_.Count() >= MIN_ITERATIONS &&
+          2.0 * estimate_.HalfWidth() < epsilon_ &&
+          estimate_.Count() * estimate_.HalfWidth() >= RULE_OF_THREE) {
+        cache_ = nullptr;
+        return estimate_.Mean();
+      }
+    }
+  }
+  cache_ = nullptr;
+  return estimate_.Mean();
+}
 
-    auto prob_map = fixed_ ? SampleFixed(sample_edges) : SampleRandom();
+void SamplingSolver::DrawBatch(int first, int count, Edges &sample_edges,
+                               Iteration *iterations) {
+  batch_.Clear();
+  for (int i = 0; i < count; i++) {
+    int iteration = first + i;
+    rng_ = Philox(seed_, iteration);
+    if (replicates_ > 0) {
+      lattice_point_ = iteration % replicate_points_;
+      lattice_replicate_ = iteration / replicate_points_;
+    }
+    if (importance_)
+      ChooseImportancePath();
+    Iteration &drawn = iterations[i];
+    drawn.sample = fixed_ ? SampleFixed(sample_edges) : SampleRandom();
+    drawn.weight = importance_ ? LikelihoodRatio(drawn.sample) : 1.0;
+    batch_.Add(drawn.sample);
+  }
+  Lanes never, always;
+  batch_.Classify(never, always);
+  for (int i = 0; i < count; i++) {
+    Iteration &drawn = iterations[i];
+    drawn.solved = ((never | always) >> i) & 1;
+    drawn.value = (always >> i) & 1 ? drawn.weight : 0.0;
+  }
+}
 
-    graph.UpdateWeights(prob_map);
-    graph.Minimize();
+double SamplingSolver::SolveCached(const Sample &sample) {
+  if (cache_) {
+    lock_guard<mutex> guard(cache_->lock);
+    auto found = cache_->values.find(sample);
+    if (found != cache_->values.end())
+      return found->second;
+  }
+  view_.Reset();
+  view_.ApplySample(sample);
+  double value = SolveSample(view_);
+  if (cache_) {
+    lock_guard<mutex> guard(cache_->lock);
+    if (cache_->values.size() < MAX_CACHED_SAMPLES)
+      cache_->values.emplace(sample, value);
+  }
+  return value;
+}
 
-    //graph.Print();
-    if (graph.CountArcs() > 1) {
-      SausageSolver solver(graph);
-      result += solver.Solve();
-    } else if (graph.CountArcs() == 1)
-      result += 1.0;
-    else
-      result += 0.0;
+void SamplingSolver::RunParallel(int count,
+                                 const function<void(int, int)> &body) {
+  if (pool_) {
+    pool_->ParallelFor(count, body);
+  } else {
+    for (int i = 0; i < count; i++) {
+      body(i, 0);
+    }
   }
-  return result / double(num_iteration_);
 }
 
-void SamplingSolver::InitRand() {
-  timeval time;
-  gettimeofday(&time, NULL);
-  theRandomMT_.seed((time.tv_sec * 1000) + (time.tv_usec / 1000));
-  theRandomGenerator_ = std::uniform_real_distribution<double>(0.0, 1.0);
+double SamplingSolver::SolveSample(GraphView &view) {
+  view.Minimize();
+  double miss = view.RemoveDirectArcs();
+  double prob = 0.0;
+  if (view.CountArcs() > 0) {
+    SausageSolver solver(view, base_cuts_);
+    prob = solver.Solve();
+  }
+  return 1.0 - miss * (1.0 - prob);
 }
 
-// Returns a map keyed by edge id and values giving the random
-// probability for that. Edges with probability greater than
-// their weight can then be replaced by 1 and less than by 0.
-unordered_map<int, double> SamplingSolver::SampleFixed(Edges &sampleEdges) {
-  unordered_map<int, double> edge_prob;
-  FOREACH_BS(edge_id, sampleEdges) { edge_prob[edge_id] = NextRand(); }
-  return edge_prob;
+double SamplingSolver::PredictSampleCost(GraphView &view) {
+  view.Minimize();
+  view.RemoveDirectArcs();
+  if (view.CountArcs() == 0)
+    return 0.0;
+  SausageSolver solver(view, base_cuts_);
+  return solver.PredictCost();
 }
 
-unordered_map<int, double> SamplingSolver::SampleRandom() {
-  unordered_map<int, double> edge_prob;
+void SamplingSolver::InitThresholds() {
+  unordered_map<int, EdgeInfo> edge_info;
+  graph_.GetEdgeInfo(edge_info);
+  thresholds_.resize(graph_.GetInnerG().maxArcId() + 1);
+  for (auto &info : edge_info) {
+    thresholds_[info.first] = ProbabilityThreshold(info.second.p);
+  }
+  if (importance_) {
+    InitImportance(edge_info);
+  }
+  success_threshold_ = ProbabilityThreshold(success_prob_);
+  base_cuts_ = graph_.FindSomeGoodCuts();
+  batch_ = SampleBatch(graph_);
   Edges all_edges = graph_.EdgesAsBitset();
-  FOREACH_BS(edge_id, all_edges) {
-    if (NextRand() >= success_prob_) {
-      edge_prob[edge_id] = NextRand();
+  FOREACH_BS(edge_id, all_edges) { edge_ids_.push_back(edge_id); }
+}
+
+void SamplingSolver::InitImportance(unordered_map<int, EdgeInfo> &edge_info) {
+  const double blocked = numeric_limits<double>::infinity();
+  const size_t max_paths = 8;
+  ListDigraph &g = graph_.GetInnerG();
+  ListDigraph::ArcMap<double> length(g);
+  for (ListDigraph::ArcIt arc(g); arc != INVALID; ++arc) {
+    double p = edge_info[g.id(arc)].p;
+    length[arc] = p > 0.0 ? -log(p) : blocked;
+  }
+  ListDigraph::Node source = graph_.GetNode(SOURCE);
+  ListDigraph::Node sink = graph_.GetNode(SINK);
+
+  double total_path_prob = 0.0;
+  for (size_t tries = 0; tries < 4 * max_paths && paths_.size() < max_paths;
+       tries++) {
+    Dijkstra<ListDigraph, ListDigraph::ArcMap<double>> dijkstra(g, length);
+    if (!dijkstra.run(source, sink) || dijkstra.dist(sink) == blocked)
+      break;
+    double path_prob = exp(-dijkstra.dist(sink));
+    if (path_prob >= 0.5) // not a rare event, no need to bias
+      break;
+
+    // q = p^alpha on the path, with prod(q) = 1/2
+    double alpha = log(0.5) / log(path_prob);
+    ImportancePath path;
+    path.weight = path_prob;
+    path.thresholds = thresholds_;
+    path.present_ratios.resize(thresholds_.size());
+    path.absent_ratios.resize(thresholds_.size());
+    for (ListDigraph::Node node = sink; node != source;) {
+      ListDigraph::Arc arc = dijkstra.predArc(node);
+      int edge_id = g.id(arc);
+      double p = edge_info[edge_id].p;
+      node = g.source(arc);
+      if (p >= 1.0) // terminal arcs, shared by all paths
+        continue;
+      // make the next paths prefer other arcs: halve this one
+      length[arc] += log(2.0);
+      path.thresholds[edge_id] = ProbabilityThreshold(pow(p, alpha));
+      // the ratios use the probability actually sampled by the threshold
+      double q = path.thresholds[edge_id] / 4294967296.0;
+      p = thresholds_[edge_id] / 4294967296.0;
+      path.present_ratios[edge_id] = q / p;
+      path.absent_ratios[edge_id] = (1.0 - q) / (1.0 - p);
+      path.edges.set(edge_id);
     }
+    bool found = false;
+    for (auto &other : paths_) {
+      found = found || other.edges == path.edges;
+    }
+    if (found)
+      continue;
+    total_path_prob += path_prob;
+    paths_.push_back(path);
+  }
+  if (paths_.empty())
+    return;
+
+  // keep some plain samples so that no sample gets a huge ratio
+  defensive_weight_ = 0.2;
+  for (auto &path : paths_) {
+    path.weight *= (1.0 - defensive_weight_) / total_path_prob;
+  }
+}
+
+void SamplingSolver::ChooseImportancePath() {
+  sample_path_ = -1;
+  double choice = NextRand() - defensive_weight_;
+  for (size_t i = 0; i < paths_.size(); i++) {
+    if (choice < 0.0)
+      break;
+    sample_path_ = i;
+    choice -= paths_[i].weight;
+  }
+}
+
+double SamplingSolver::LikelihoodRatio(const Sample &sample) {
+  double mixture = defensive_weight_;
+  for (auto &path : paths_) {
+    double ratio = path.weight;
+    Edges present = sample.present & path.edges;
+    FOREACH_BS(edge_id, present) { ratio *= path.present_ratios[edge_id]; }
+    Edges absent = sample.absent & path.edges;
+    FOREACH_BS(edge_id, absent) { ratio *= path.absent_ratios[edge_id]; }
+    mixture += ratio;
+  }
+  return 1.0 / mixture;
+}
+
+void SamplingSolver::FillDraws(size_t count) {
+  draws_.resize(count);
+  size_t first = 0;
+  if (lattice_point_ >= 0) {
+    // all the points of a replicate share its shift
+    Philox shift(seed_, SHIFT_STREAM + lattice_replicate_);
+    first = min(count, (size_t)lattice_.Dimension());
+    for (size_t i = 0; i < first; i++) {
+      draws_[i] = lattice_.Coordinate(lattice_point_, i) + shift();
+    }
+  }
+  for (size_t i = first; i < count; i++) {
+    draws_[i] = rng_();
   }
-  return edge_prob;
 }
 
-unordered_map<int, double>
-SamplingSolver::SampleWeightedRandom(vector<EdgeSubset> &edge_subsets) {
-  unordered_map<int, double> edge_prob;
+Sample SamplingSolver::SampleFixed(Edges &sampleEdges) {
+  Sample sample;
+  vector<uint64_t> &thresholds = SampleThresholds();
+  FillDraws(sampleEdges.count());
+  size_t draw = 0;
+  FOREACH_BS(edge_id, sampleEdges) {
+    if (draws_[draw++] < thresholds[edge_id])
+      sample.present.set(edge_id);
+    else
+      sample.absent.set(edge_id);
+  }
+  return sample;
+}
+
+Edges SamplingSolver::SampleWorld() {
+  Edges world;
+  FillDraws(edge_ids_.size());
+  for (size_t i = 0; i < edge_ids_.size(); i++) {
+    if (draws_[i] < thresholds_[edge_ids_[i]])
+      world.set(edge_ids_[i]);
+  }
+  return world;
+}
+
+Sample SamplingSolver::SampleRandom() {
+  Sample sample;
+  vector<uint64_t> &thresholds = SampleThresholds();
+  // two draws per edge: whether to sample it, then its state
+  FillDraws(2 * edge_ids_.size());
+  for (size_t i = 0; i < edge_ids_.size(); i++) {
+    int edge_id = edge_ids_[i];
+    if (draws_[2 * i] < success_threshold_)
+      continue;
+    if (draws_[2 * i + 1] < thresholds[edge_id])
+      sample.present.set(edge_id);
+    else
+      sample.absent.set(edge_id);
+  }
+  return sample;
+}
+
+Sample SamplingSolver::SampleWeightedRandom() {
   Edges sample_edges;
-  vector<int> chances = GetChanceVector(edge_subsets);
-  int budget = (int)ceil(graph_.CountArcs() * success_prob_);
-
-  while (budget > 0 && chances.size() > 0) {
-    int index = (int)floor(NextRand() * chances.size());
-    FOREACH_BS(edge_id, edge_subsets[chances[index]].GetEdges()) {
-      if (edge_prob.find(edge_id) == edge_prob.end()) {
-        edge_prob[edge_id] = NextRand();
+  int budget = (int)ceil(graph_.CountArcs() * (1.0 - success_prob_));
+
+  // Draws subsets without replacement: a subset drawn again is rejected,
+  // and the table is rebuilt over the subsets left once they weigh less
+  // than half of it, so a draw takes at most two tries on average.
+  AliasTable table = subset_table_;
+  vector<int> table_subsets(edge_subsets_.size());
+  for (size_t i = 0; i < edge_subsets_.size(); i++) {
+    table_subsets[i] = i;
+  }
+  vector<bool> taken(edge_subsets_.size(), false);
+  double taken_weight = 0.0;
+  while (budget > 0 && table.Total() > 0.0) {
+    int index = table_subsets[table.Sample(NextRand())];
+    if (taken[index])
+      continue;
+    taken[index] = true;
+    taken_weight += edge_subsets_[index].Weight();
+    FOREACH_BS(edge_id, edge_subsets_[index].GetEdges()) {
+      if (!sample_edges[edge_id]) {
         sample_edges.set(edge_id);
         budget--;
         if (budget == 0)
@@ -75,102 +344,137 @@ SamplingSolver::SampleWeightedRandom(vector<EdgeSubset> &edge_subsets) {
       }
     }
 
-    int temp = index - 1;
-    while (temp >= 0 && chances[temp] == chances[index])
-      temp--;
-    int start = temp + 1;
-    temp = index + 1;
-    while (temp < chances.size() && chances[temp] == chances[index])
-      temp++;
-    int end = temp - 1;
-    chances.erase(chances.begin() + start, chances.begin() + end);
+    if (2.0 * taken_weight > table.Total()) {
+      vector<double> weights;
+      table_subsets.clear();
+      for (size_t i = 0; i < edge_subsets_.size(); i++) {
+        if (!taken[i]) {
+          table_subsets.push_back(i);
+          weights.push_back(edge_subsets_[i].Weight());
+        }
+      }
+      table = AliasTable(weights);
+      taken_weight = 0.0;
+    }
   }
 
   if (budget > 0) {
     Edges all_edges = graph_.EdgesAsBitset();
-    Edges remaining_edges = all_edges | ~sample_edges;
+    Edges remaining_edges = all_edges & ~sample_edges;
     vector<int> remaining_edge_ids;
     FOREACH_BS(id, remaining_edges) remaining_edge_ids.push_back(id);
 
-    while (budget > 0) {
-      int edge_id = (int)floor(NextRand() * remaining_edge_ids.size());
-      if (edge_prob.find(edge_id) == edge_prob.end()) {
-        edge_prob[edge_id] = NextRand();
-        budget--;
-        if (budget == 0)
-          break;
-      }
+    while (budget > 0 && remaining_edge_ids.size() > 0) {
+      int index = (int)floor(NextRand() * remaining_edge_ids.size());
+      sample_edges.set(remaining_edge_ids[index]);
+      remaining_edge_ids[index] = remaining_edge_ids.back();
+      remaining_edge_ids.pop_back();
+      budget--;
     }
   }
-  return edge_prob;
-}
-
-vector<int> SamplingSolver::GetChanceVector(vector<EdgeSubset> &edge_subsets) {
-  double min_weight = numeric_limits<double>::max();
-  double max_weight = 0.0;
-  for (auto &subset : edge_subsets) {
-    double weight = subset.Weight();
-    if (weight < min_weight)
-      min_weight = weight;
-    if (weight > max_weight)
-      max_weight = weight;
-  }
-  double weight_range = max_weight - min_weight;
-  vector<int> chances;
-  int index = 0;
-  for (auto &subset : edge_subsets) {
-    // normalization
-    double weight_ratio = (subset.Weight() - min_weight) * 100.0 / weight_range;
-    int num_chance = (int)ceil(weight_ratio);
-    while (num_chance--) {
-      chances.push_back(index);
-    }
-    index++;
+  return SampleFixed(sample_edges);
+}
+
+void SamplingSolver::InitEdgeSubsets() {
+  unordered_map<int, EdgeInfo> edge_info;
+  graph_.GetEdgeInfo(edge_info);
+  OutArcs out_arcs = graph_.GetOutArcs();
+  auto cuts = graph_.FindSomeGoodCuts();
+  int id = 0;
+  vector<double> weights;
+  for (auto &cut : cuts) {
+    edge_subsets_.emplace_back(id++, cut, out_arcs, edge_info);
+    weights.push_back(edge_subsets_.back().Weight());
   }
+  subset_table_ = AliasTable(weights);
 }
 
 Edges SamplingSolver::Probe() {
-  vector<EdgeSubset> edge_subsets;
+  rng_ = Philox(seed_, PROBE_STREAM);
   if (weighted_) {
-    unordered_map<int, EdgeInfo> edge_info;
-    graph_.GetEdgeInfo(edge_info);
-    auto cuts = graph_.FindSomeGoodCuts();
-    int id = 0;
-    vector<EdgeSubset> edge_subsets;
-    for (auto &cut : cuts) {
-      edge_subsets.emplace_back(id++, cut, edge_info);
-    }
+    InitEdgeSubsets();
   }
 
-  Edges min_time_edges;
-  double min_time = numeric_limits<double>::max();
+  vector<Edges> candidates;
   for (int i = 0; i < probe_size_; i++) {
-    double probe_time = 0.0;
-    unordered_map<int, double> prob_map =
-        weighted_ ? SampleWeightedRandom(edge_subsets) : SampleRandom();
-    Edges sampleEdges;
-    for (auto &edge : prob_map) {
-      sampleEdges.set(edge.first);
+    Sample probe_sample = weighted_ ? SampleWeightedRandom() : SampleRandom();
+    candidates.push_back(probe_sample.Sampled());
+  }
+  if (candidates.empty())
+    return Edges();
+  if (timed_probe_)
+    return RaceCandidates(candidates);
+
+  // common random numbers: all candidates are evaluated on the same worlds
+  vector<Edges> worlds;
+  // predicting is cheap, so use more worlds than timed probing would
+  for (int i = 0; i < max(MIN_PREDICTED_WORLDS, probe_repeat_); i++) {
+    worlds.push_back(SampleWorld());
+  }
+  size_t best = 0;
+  double min_cost = numeric_limits<double>::max();
+  for (size_t i = 0; i < candidates.size(); i++) {
+    double cost = 0.0;
+    for (auto &world : worlds) {
+      Sample sample;
+      sample.present = candidates[i] & world;
+      sample.absent = candidates[i] & ~world;
+      view_.Reset();
+      view_.ApplySample(sample);
+      cost += PredictSampleCost(view_);
+    }
+    if (cost < min_cost) {
+      min_cost = cost;
+      best = i;
     }
-    for (int j = 0; j < probe_repeat_; j++) {
-      Graph graph;
-      graph.CopyFrom(graph_);
-      auto fixed_prob_map = SampleFixed(sampleEdges);
-      graph.UpdateWeights(fixed_prob_map);
-      graph.Minimize();
+  }
+  return candidates[best];
+}
+
+Edges SamplingSolver::RaceCandidates(vector<Edges> &candidates) {
+  vector<GraphView> views(pool_ ? pool_->NumThreads() : 1, view_);
+  vector<double> times(candidates.size(), 0.0);
+  vector<int> alive;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    alive.push_back(i);
+  }
+  int num_worlds = 1;
+  while (alive.size() > 1 && probe_repeat_ > 0) {
+    // common random numbers: all candidates are timed on the same worlds,
+    // so they are compared on the same sub-solves
+    vector<Edges> worlds;
+    for (int i = 0; i < num_worlds; i++) {
+      worlds.push_back(SampleWorld());
+    }
+    TimeCandidates(candidates, alive, worlds, views, times);
+    // keep the faster half, by total time over all the rounds so far
+    sort(alive.begin(), alive.end(),
+         [&times](int a, int b) { return times[a] < times[b]; });
+    alive.resize((alive.size() + 1) / 2);
+    num_worlds = min(2 * num_worlds, probe_repeat_);
+  }
+  return candidates[alive.front()];
+}
+
+void SamplingSolver::TimeCandidates(vector<Edges> &candidates,
+                                    vector<int> &alive, vector<Edges> &worlds,
+                                    vector<GraphView> &views,
+                                    vector<double> &times) {
+  auto time_one = [&](int i, int thread_id) {
+    GraphView &view = views[thread_id];
+    Edges &edges = candidates[alive[i]];
+    for (auto &world : worlds) {
+      Sample sample;
+      sample.present = edges & world;
+      sample.absent = edges & ~world;
+      view.Reset();
+      view.ApplySample(sample);
 
       double t_start = GetCPUTime();
-      if (graph.CountArcs() > 1) {
-        SausageSolver solver(graph);
-        double val = solver.Solve();
-      }
+      SolveSample(view);
       double t_end = GetCPUTime();
-      probe_time += t_end - t_start;
-    }
-    if (probe_time < min_time) {
-      min_time = probe_time;
-      min_time_edges = sampleEdges;
+      times[alive[i]] += t_end - t_start;
     }
-  }
-  return min_time_edges;
-}
\ No newline at end of file
+  };
+  RunParallel(alive.size(), time_one);
+}
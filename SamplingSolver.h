@@ -1,41 +1,109 @@
 #ifndef SAMPLING_SOLVER_H
 #define SAMPLING_SOLVER_H
 
+#include "Accumulator.h"
+#include "AliasTable.h"
 #include "EdgeSubset.h"
 #include "Graph.h"
+#include "GraphView.h"
+#include "Lattice.h"
+#include "Philox.h"
+#include "Sample.h"
+#include "SampleBatch.h"
 #include "SausageSolver.h"
+#include "ThreadPool.h"
 #include "Util.h"
+#include <algorithm>
+#include <cmath>
+#include <lemon/dijkstra.h>
 #include <limits>
-#include <random>
-#include <sys/time.h>
+#include <mutex>
+#include <unordered_map>
+#include <time.h>
 using namespace std;
+using lemon::Dijkstra;
+
+// Samples always taken before the confidence interval is trusted for an
+// early stop.
+const int MIN_ITERATIONS = 100;
+
+// The normal confidence interval says nothing of the outcomes not sampled
+// yet, and rare events (a few unlikely edges present) are exactly those. An
+// outcome never seen in n iterations has a probability of at most 3 / n
+// (rule of three, at 95%), so with values at most 1 it shifts the mean by
+// at most that much: early stops also wait for 3 / n to be within the half
+// width. Rare events then run to the iteration cap. Importance sampling
+// values may exceed 1, and are not covered.
+const double RULE_OF_THREE = 3.0;
+
+// Sampled worlds at least used to average the predicted cost of each probe
+// candidate. Fewer make the ranking noisy.
+const int MIN_PREDICTED_WORLDS = 32;
+
+// Random streams of the probing phase, after those of the iterations.
+const uint64_t PROBE_STREAM = 1ull << 63;
+
+// Random streams of the shifts of the quasi-Monte Carlo replicates.
+const uint64_t SHIFT_STREAM = 1ull << 62;
+
+// Sampled configurations at most remembered by the cache of a Solve().
+const size_t MAX_CACHED_SAMPLES = 1 << 16;
+
+// Iterations per thread computed between two reductions of the results
+// (and checks of the early stop): one batch of samples sorted out at once
+// by a SampleBatch.
+const int ITERATION_BLOCK = NUM_LANES;
 
 class SamplingSolver {
 public:
   SamplingSolver(Graph &graph, int num_iteration, double success_prob,
-                 int probe_size, int probe_repeat, bool fixed, bool weighted)
+                 int probe_size, int probe_repeat, bool fixed, bool weighted,
+                 bool importance = false, double epsilon = 0.0,
+                 bool timed_probe = false, uint64_t seed = 0,
+                 ThreadPool *pool = nullptr, int replicates = 0)
       : num_iteration_(num_iteration), success_prob_(success_prob),
         probe_size_(probe_size), probe_repeat_(probe_repeat), fixed_(fixed),
-        weighted_(weighted), graph_(graph) {
-    InitRand();
+        weighted_(weighted), importance_(importance), epsilon_(epsilon),
+        timed_probe_(timed_probe), graph_(graph), view_(graph), seed_(seed),
+        pool_(pool), replicates_(replicates) {
+    if (replicates_ > 0) {
+      replicate_points_ = num_iteration_ / replicates_;
+      num_iteration_ = replicate_points_ * replicates_;
+    }
+    InitThresholds();
   }
 
   // Main solver method. It decides what kind of sampling to use and
   // then performs the calculation a number of times and averages the result.
+  // The iterations run on pool_ when there is one.
   double Solve();
 
+  // Statistics of the per-iteration estimates of the last Solve(), of the
+  // per-replicate estimates with replicates_.
+  const Accumulator &GetEstimate() { return estimate_; }
+
+  // Runs only the iterations [first, first + count) of the index space,
+  // e.g. one shard of a run split over several processes. With replicates_,
+  // both must be whole replicates.
+  void SetIterations(int first, int count) {
+    first_iteration_ = first;
+    num_iteration_ = count;
+  }
+
 private:
-  // Total number of iterations to perform.
+  // Total number of iterations to perform, the cap when epsilon_ is set.
   int num_iteration_;
 
+  // Index of the first iteration, iteration i using random stream i.
+  int first_iteration_ = 0;
+
   // Probability of bernoulli sampling.
   double success_prob_;
 
   // When probing for best sample, the number of times to probe.
   int probe_size_;
 
-  // For each probe sample, number of times to perform calculation
-  // for averaging.
+  // For each probe sample, number of sampled worlds to evaluate it on.
   int probe_repeat_;
 
   // Flag to decide if sampling is fixed or random everytime.
@@ -45,47 +113,209 @@ private:
   // when fixed_ is set to true.
   bool weighted_;
 
+  // Flag to bias the sampled edge states towards the most probable
+  // SOURCE --> SINK path, each sample is then reweighted by its likelihood
+  // ratio. Meant for tiny reachability probabilities.
+  bool importance_;
+
+  // When positive, iterations stop as soon as the 95% confidence interval
+  // of the result is narrower than epsilon_ (see RULE_OF_THREE).
+  double epsilon_;
+
+  Accumulator estimate_;
+
+  // Flag to rank probe candidates by timing trial solves instead of by the
+  // cost predicted from their cuts.
+  bool timed_probe_;
+
   // Reference to main graph passed in my main.
   Graph &graph_;
 
-  mt19937 theRandomMT_;
+  // Scratch view of graph_, reset and sampled at every iteration.
+  GraphView view_;
+
+  uint64_t seed_;
+
+  // Random stream of the current iteration: iteration i draws from stream
+  // i of seed_, probing from PROBE_STREAM on.
+  Philox rng_;
+
+  // Threads to run the iterations and the timed probes on, none to run
+  // them on the calling thread.
+  ThreadPool *pool_;
+
+  // When positive, the edge states are drawn from replicates_ randomly
+  // shifted copies of a lattice of replicate_points_ points (one dimension
+  // per draw) instead of independently, iteration i being point
+  // i % replicate_points_ of replicate i / replicate_points_. The estimate
+  // is then the mean of the replicates, its error their spread.
+  int replicates_;
+  int replicate_points_ = 0;
+  Lattice lattice_;
+
+  // Lattice point and replicate of the current iteration, -1 outside of
+  // the iterations (probing).
+  int lattice_point_ = -1;
+  int lattice_replicate_ = -1;
+
+  // Probabilities pre-scaled to 32 bit thresholds (see ProbabilityThreshold),
+  // edge sampling probabilities indexed by edge id and the bernoulli success
+  // probability.
+  vector<uint64_t> thresholds_;
+  uint64_t success_threshold_;
+
+  // Importance sampling (importance_ only) draws every sample from a
+  // mixture: with probability defensive_weight_ the plain edge weights, else
+  // one of paths_, where the edges of a probable SOURCE --> SINK path get a
+  // biased probability q instead of their weight p.
+  struct ImportancePath {
+    Edges edges;
+    // Probability of picking this path in the mixture.
+    double weight;
+    // Like thresholds_, with the biased probabilities on the path.
+    vector<uint64_t> thresholds;
+    // q / p and (1 - q) / (1 - p) on the path, indexed by edge id.
+    vector<double> present_ratios;
+    vector<double> absent_ratios;
+  };
+  vector<ImportancePath> paths_;
+  double defensive_weight_ = 1.0;
 
-  uniform_real_distribution<double> theRandomGenerator_;
+  // Path of paths_ whose thresholds the next sample uses, -1 for
+  // thresholds_.
+  int sample_path_ = -1;
 
-  // Initialize seed for random number generation.
-  void InitRand();
+  vector<uint64_t> &SampleThresholds() {
+    return sample_path_ < 0 ? thresholds_ : paths_[sample_path_].thresholds;
+  }
+
+  // Sub-solve results by sampled configuration (fixed_ only): the same few
+  // edges being sampled every iteration, configurations recur and are
+  // solved once. Shared by the threads of a Solve(), so under a lock;
+  // results are the same whichever thread computes them first.
+  struct SampleCache {
+    mutex lock;
+    unordered_map<Sample, double, SampleHash> values;
+  };
+  SampleCache *cache_ = nullptr;
+
+  // Edges from the left to the middle of each cut of graph_ (weighted_
+  // only), and a table to draw them by weight.
+  vector<EdgeSubset> edge_subsets_;
+  AliasTable subset_table_;
+
+  // Cuts of graph_, projected onto every sampled view instead of finding
+  // its cuts again.
+  vector<Cut> base_cuts_;
+
+  // Sorts out the samples that do not need an exact solve.
+  SampleBatch batch_;
+
+  // An iteration of Solve(): its sample, the likelihood ratio of the
+  // sample (importance_ only) and the estimate once known.
+  struct Iteration {
+    Sample sample;
+    double weight = 1.0;
+    double value = 0.0;
+    bool solved = false;
+  };
+
+  // Ids of all edges of graph_.
+  vector<int> edge_ids_;
+
+  // Buffer of uniform 32 bit draws, refilled in bulk for every sample.
+  vector<uint32_t> draws_;
+
+  void InitThresholds();
+
+  // Finds a few of the most probable SOURCE --> SINK paths (shortest paths
+  // for -log p, each found path making its arcs less attractive for the
+  // next ones). The probabilities on each path are raised to the
+  // same power so that the whole path is present with probability one
+  // half, and the paths are weighted by their original probability.
+  void InitImportance(unordered_map<int, EdgeInfo> &edge_info);
+
+  // Picks the mixture component the next sample is drawn from.
+  void ChooseImportancePath();
+
+  // Ratio of the plain to the mixture probability of a sample (balance
+  // heuristic over all the paths, whichever one it was drawn from).
+  double LikelihoodRatio(const Sample &sample);
 
   // Get a random number between 0 and 1.
-  double NextRand() { return theRandomGenerator_(theRandomMT_); }
+  double NextRand() { return rng_.NextDouble(); }
+
+  // Refills draws_ with count uniform 32 bit numbers, the first ones from
+  // the shifted lattice point of the iteration with replicates_.
+  void FillDraws(size_t count);
+
+  // Draws the samples of the count <= NUM_LANES iterations from first on,
+  // each with its own stream of seed_, and solves those that trivially
+  // give 0 or 1.
+  void DrawBatch(int first, int count, Edges &sample_edges,
+                 Iteration *iterations);
 
-  // Get current time for time measurement.
-  double GetCPUTime() { return (double)clock() / (CLOCKS_PER_SEC / 1000); }
+  // Solves sample exactly on view_, or finds it in cache_.
+  double SolveCached(const Sample &sample);
 
-  // Returns a map keyed by edge id and values giving the random
-  // probability for that edge. Edges with probability greater than
-  // their weight can then be replaced by 1 and less than by 0.
-  // sampleEdges denotes the fixed edges found from probing. Only
-  // these edges will be sampled.
-  unordered_map<int, double> SampleFixed(Edges &sampleEdges);
+  // Runs body(i, thread_id) for i in [0, count), on pool_ if any.
+  void RunParallel(int count, const function<void(int, int)> &body);
 
-  // In contrast to SampleFixed, this method samples all the edges
-  // in the graph with success_prob_ probability. 
-  unordered_map<int, double> SampleRandom();
+  // Minimizes a sampled view and solves it exactly.
+  double SolveSample(GraphView &view);
+
+  // Minimizes a sampled view and predicts the cost of solving it.
+  double PredictSampleCost(GraphView &view);
+
+  // CPU time of the calling thread in milliseconds. Unlike clock(), it is
+  // not affected by the other probing threads.
+  double GetCPUTime() {
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec * 1000.0 + time.tv_nsec / 1e6;
+  }
 
-  // Same as above but samples edges weighted by the cut size of the
-  // cut in which those edges occur.
-  // As input it takes in a vector of edge_subsets.
-  unordered_map<int, double>
-  SampleWeightedRandom(vector<EdgeSubset> &edge_subsets);
+  // Samples the state of every edge of graph_, the present ones are
+  // returned.
+  Edges SampleWorld();
+
+  // Returns the sampled states of the edges in sampleEdges, each edge is
+  // present with probability equal to its weight. sampleEdges denotes the
+  // fixed edges found from probing. Only these edges will be sampled.
+  Sample SampleFixed(Edges &sampleEdges);
+
+  // In contrast to SampleFixed, this method picks the edges to sample
+  // among all the edges in the graph, each with 1 - success_prob_
+  // probability.
+  Sample SampleRandom();
+
+  // Same as above but picks the edges to sample by whole edge subsets,
+  // drawn with probability proportional to their weight (see EdgeSubset).
+  Sample SampleWeightedRandom();
+
+  // Builds edge_subsets_ and subset_table_ from the cuts of graph_.
+  void InitEdgeSubsets();
 
   // Finds out the set of fixed edges to pass to SampleFixed.
   // Probing means trying out differents combinations of edges to
-  // sample and choosing the one which takes minimum time.
+  // sample and choosing the one which is the cheapest to solve, on
+  // average over sampled worlds (the same for all candidates). The cost
+  // is predicted from the cuts of each sampled sub-graph, see
+  // SausageSolver::PredictCost.
   Edges Probe();
 
-  // Creates a weighted vector of edge_subset indices depending on
-  // weight.
-  vector<int> GetChanceVector(vector<EdgeSubset> &edge_subsets);
+  // Timed probing (timed_probe_): the candidates race by successive
+  // halving, each round times the remaining ones on the same sampled
+  // worlds and drops the slower half, the number of worlds doubling every
+  // round up to probe_repeat_.
+  Edges RaceCandidates(vector<Edges> &candidates);
+
+  // Adds to times the time to solve each of the alive candidates on
+  // every world, candidates being spread over pool_ (one view per
+  // thread).
+  void TimeCandidates(vector<Edges> &candidates, vector<int> &alive,
+                      vector<Edges> &worlds, vector<GraphView> &views,
+                      vector<double> &times);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,25 @@
+#include "SamplingSolver.h"
+#include "gtest/gtest.h"
+
+namespace {
+TEST(SamplingSolverTest, SolveTwiceTest) {
+  // a second Solve() with --qmc probes from the probing streams again, not
+  // from the lattice point the last iteration of the first one left
+  // behind. A 4 x 4 grid from corner 0 to corner 15, of varied edge
+  // probabilities so that the probe candidates differ.
+  Graph graph;
+  for (int node = 0; node < 16; node++) {
+    double p = 0.3 + 0.04 * node;
+    if (node % 4 < 3)
+      graph.AddEdge(to_string(node), to_string(node + 1), p);
+    if (node < 12)
+      graph.AddEdge(to_string(node), to_string(node + 4), 1.0 - p);
+  }
+  graph.Preprocess(vector<string>{"0"}, vector<string>{"15"}, PRE_YES);
+  SamplingSolver solver(graph, 300, 0.5, 8, 40, true, false, false, 0.0,
+                        false, 7, nullptr, 3);
+  double first = solver.Solve();
+  double second = solver.Solve();
+  EXPECT_EQ(first, second);
+}
+} // namespace
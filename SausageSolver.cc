@@ -1,5 +1,15 @@
 #include "SausageSolver.h"
 
+SausageSolver::SausageSolver(GraphView &view, const vector<Cut> &base_cuts)
+    : Solver(view) {
+  cuts_ = view.FindSomeGoodCuts();
+  vector<Cut> projected;
+  if (view.ProjectCuts(base_cuts, projected) &&
+      PredictCost(projected) < PredictCost(cuts_)) {
+    cuts_ = projected;
+  }
+}
+
 double SausageSolver::Solve() {
 
   Edges covered;
@@ -32,6 +42,23 @@ double SausageSolver::Solve() {
   return P_.GetResult();
 }
 
+double SausageSolver::PredictCost(vector<Cut> cuts) {
+  // same walk over the cuts as Solve()
+  Edges covered;
+  int width = source_.count();
+  double cost = 0.0;
+  while (cuts.size() > 0) {
+    Cut nextCut = cuts.front();
+    cuts.erase(cuts.begin());
+    Edges sausage = nextCut.getCoveredEdges() & ~covered;
+    cost += SausageCost(sausage.count(), width);
+    covered |= sausage;
+    width = nextCut.size();
+    cuts = nextCut.RemoveObsoleteCuts(cuts);
+  }
+  return cost + SausageCost((all_edges_ & ~covered).count(), width);
+}
+
 void SausageSolver::ConsumeSausage(Edges &sausage, Nodes &end_nodes) {
   // Build a dictionary of edgeId -> source and target node ids
   // Will need it with each collapsation operation within this sausage
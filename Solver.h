@@ -2,6 +2,7 @@
 #define SOLVER_H
 
 #include "Graph.h"
+#include "GraphView.h"
 #include "Polynomial.h"
 
 class Solver {
@@ -13,6 +14,13 @@ public:
     all_edges_ = graph.EdgesAsBitset();
   }
 
+  Solver(GraphView &view)
+      : source_(view.GetNodeBitset(SOURCE)), P_(Polynomial(source_)) {
+    target_ = view.GetNodeBitset(SINK);
+    view.GetEdgeInfo(edge_info_);
+    all_edges_ = view.EdgesAsBitset();
+  }
+
   virtual double Solve() = 0;
 
 protected:
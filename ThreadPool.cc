@@ -0,0 +1,72 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int num_threads) : next_(0) {
+  num_threads_ = num_threads > 0 ? num_threads
+                                 : max(1u, thread::hardware_concurrency());
+  for (int thread_id = 1; thread_id < num_threads_; thread_id++) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this, thread_id);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+vector<unique_ptr<ThreadPool>> ThreadPool::InlinePools() {
+  vector<unique_ptr<ThreadPool>> pools;
+  for (int i = 0; i < num_threads_; i++) {
+    pools.emplace_back(new ThreadPool(1));
+  }
+  return pools;
+}
+
+void ThreadPool::ParallelFor(int count, const function<void(int, int)> &task) {
+  if (workers_.empty() || count <= 1) {
+    for (int i = 0; i < count; i++) {
+      task(i, 0);
+    }
+    return;
+  }
+  {
+    lock_guard<mutex> lock(mutex_);
+    task_ = &task;
+    count_ = count;
+    next_ = 0;
+    busy_ = workers_.size();
+    generation_++;
+  }
+  start_.notify_all();
+  RunTasks(0);
+  unique_lock<mutex> lock(mutex_);
+  done_.wait(lock, [this] { return busy_ == 0; });
+}
+
+void ThreadPool::WorkerLoop(int thread_id) {
+  long seen = 0;
+  while (true) {
+    {
+      unique_lock<mutex> lock(mutex_);
+      start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_)
+        return;
+      seen = generation_;
+    }
+    RunTasks(thread_id);
+    lock_guard<mutex> lock(mutex_);
+    if (--busy_ == 0)
+      done_.notify_one();
+  }
+}
+
+void ThreadPool::RunTasks(int thread_id) {
+  for (int i = next_++; i < count_; i = next_++) {
+    (*task_)(i, thread_id);
+  }
+}
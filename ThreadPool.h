@@ -0,0 +1,61 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// A fixed set of threads running parallel loops. The calling thread takes
+// part in every loop, so a pool of one thread runs everything inline.
+// Loop indices are handed out one at a time, so uneven tasks balance out.
+class ThreadPool {
+public:
+  // num_threads <= 0 means one thread per core.
+  ThreadPool(int num_threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int NumThreads() { return num_threads_; }
+
+  // Calls task(index, thread_id) for every index in [0, count) and returns
+  // once all are done. thread_id is in [0, NumThreads()) and identifies
+  // the thread running the task, for per-thread scratch space.
+  void ParallelFor(int count, const function<void(int, int)> &task);
+
+  // One pool of a single thread per thread of this one, for the tasks of
+  // ParallelFor to run their own parallel loops inline (loops do not nest).
+  vector<unique_ptr<ThreadPool>> InlinePools();
+
+private:
+  int num_threads_;
+  vector<thread> workers_;
+
+  mutex mutex_;
+  condition_variable start_;
+  condition_variable done_;
+
+  // Current loop, guarded by mutex_ except for next_.
+  const function<void(int, int)> *task_ = nullptr;
+  int count_ = 0;
+  atomic<int> next_;
+  // Workers still in the current loop.
+  int busy_ = 0;
+  // Incremented for every loop, so that workers notice a new one.
+  long generation_ = 0;
+  bool stop_ = false;
+
+  void WorkerLoop(int thread_id);
+
+  // Runs loop indices until none is left.
+  void RunTasks(int thread_id);
+};
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <bitset>
+#include <cstdint>
 #include <unordered_map>
 
 #define NUM_EDGES 1024
@@ -12,6 +13,11 @@ typedef std::bitset<NUM_EDGES> Edges;
 typedef std::bitset<NUM_NODES> Nodes;
 typedef std::unordered_map<int, std::pair<int, int>> EDGE_INFO;
 
+// One possible world per bit: 64 worlds are sampled and traversed at once.
+typedef uint64_t Lanes;
+
+const int NUM_LANES = 64;
+
 #define FOREACH_BS(v, vSet)	  \
 	for (size_t v=vSet._Find_first(); v!=vSet.size(); v=vSet._Find_next(v))
 
@@ -0,0 +1,118 @@
+#include "WorldIndex.h"
+
+// First line of an index file.
+const string INDEX_MAGIC = "preach-world-index 1";
+
+WorldIndex::WorldIndex(Graph &graph, int num_worlds, uint64_t seed)
+    : num_batches_((num_worlds + NUM_LANES - 1) / NUM_LANES), seed_(seed) {
+  ListDigraph &g = graph.GetInnerG();
+  vector<int> index_of(g.maxNodeId() + 1, -1);
+  for (ListDigraph::NodeIt node(g); node != INVALID; ++node) {
+    index_of[g.id(node)] = names_.size();
+    indices_[graph.GetName(node)] = names_.size();
+    names_.push_back(graph.GetName(node));
+  }
+  unordered_map<int, EdgeInfo> edge_info;
+  graph.GetEdgeInfo(edge_info);
+  vector<uint64_t> thresholds;
+  for (ListDigraph::ArcIt arc(g); arc != INVALID; ++arc) {
+    EdgeInfo &info = edge_info[g.id(arc)];
+    arcs_.push_back({index_of[info.edge_terminals.first],
+                     index_of[info.edge_terminals.second]});
+    thresholds.push_back(ProbabilityThreshold(info.p));
+  }
+  BuildOutArcs();
+
+  words_.resize((size_t)num_batches_ * arcs_.size());
+  for (int batch = 0; batch < num_batches_; batch++) {
+    Philox rng(seed_, batch);
+    Lanes *words = &words_[(size_t)batch * arcs_.size()];
+    for (size_t arc = 0; arc < arcs_.size(); arc++) {
+      words[arc] = SampleLanes(rng, thresholds[arc]);
+    }
+  }
+}
+
+void WorldIndex::BuildOutArcs() {
+  OutArcs out_arcs(names_.size());
+  for (size_t arc = 0; arc < arcs_.size(); arc++) {
+    out_arcs[arcs_[arc].source].emplace_back(arc, arcs_[arc].target);
+  }
+  bfs_ = LaneBfs(out_arcs);
+}
+
+vector<int> WorldIndex::Lookup(const vector<string> &names) {
+  vector<int> nodes;
+  for (auto &name : names) {
+    auto found = indices_.find(name);
+    if (found != indices_.end())
+      nodes.push_back(found->second);
+  }
+  return nodes;
+}
+
+double WorldIndex::Query(const vector<string> &sources,
+                         const vector<string> &targets,
+                         Accumulator &estimate) {
+  vector<int> source_nodes = Lookup(sources);
+  vector<int> target_nodes = Lookup(targets);
+  long reaching = 0;
+  for (int batch = 0; batch < num_batches_; batch++) {
+    // from all the sources at once
+    const vector<Lanes> &reached =
+        bfs_.Reach(words_.data() + (size_t)batch * arcs_.size(), source_nodes);
+    Lanes hit = 0;
+    for (int node : target_nodes) {
+      hit |= reached[node];
+    }
+    reaching += __builtin_popcountll(hit);
+  }
+
+  estimate = Accumulator();
+  estimate.Add(1.0, reaching);
+  estimate.Add(0.0, NumWorlds() - reaching);
+  return estimate.Mean();
+}
+
+void WorldIndex::Write(ostream &out) const {
+  out << INDEX_MAGIC << "\n" << seed_ << " " << num_batches_ << "\n";
+  out << names_.size() << "\n";
+  for (auto &name : names_) {
+    out << name << "\n";
+  }
+  out << arcs_.size() << "\n";
+  for (auto &arc : arcs_) {
+    out << arc.source << " " << arc.target << "\n";
+  }
+  out.write((const char *)words_.data(), words_.size() * sizeof(Lanes));
+}
+
+bool WorldIndex::Read(istream &in) {
+  string magic;
+  getline(in, magic);
+  size_t num_names, num_arcs;
+  if (magic != INDEX_MAGIC || !(in >> seed_ >> num_batches_ >> num_names))
+    return false;
+  names_.resize(num_names);
+  indices_.clear();
+  for (size_t i = 0; i < num_names; i++) {
+    in >> names_[i];
+    indices_[names_[i]] = i;
+  }
+  if (!(in >> num_arcs))
+    return false;
+  arcs_.resize(num_arcs);
+  for (auto &arc : arcs_) {
+    in >> arc.source >> arc.target;
+    if (arc.source < 0 || arc.source >= (int)num_names || arc.target < 0 ||
+        arc.target >= (int)num_names)
+      return false;
+  }
+  in.get(); // end of the last header line
+  words_.resize((size_t)num_batches_ * num_arcs);
+  in.read((char *)words_.data(), words_.size() * sizeof(Lanes));
+  if (!in)
+    return false;
+  BuildOutArcs();
+  return true;
+}
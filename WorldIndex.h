@@ -0,0 +1,75 @@
+#ifndef WORLD_INDEX_H
+#define WORLD_INDEX_H
+
+#include "Accumulator.h"
+#include "Graph.h"
+#include "LaneBfs.h"
+#include "Philox.h"
+#include "Sample.h"
+#include "Util.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Possible worlds of a whole network, sampled once and saved, to answer
+// any number of source / target queries without sampling again. Worlds are
+// stored NUM_LANES at a time, one world per bit of a word per arc, and a
+// query runs one word-parallel traversal per NUM_LANES worlds. Unlike the
+// solvers, the network is not preprocessed (nor limited in size): queries
+// may use any of its nodes.
+class WorldIndex {
+public:
+  WorldIndex() = default;
+
+  // Samples num_worlds worlds (rounded up to a multiple of NUM_LANES) of
+  // graph, batch i of NUM_LANES worlds from stream i of seed.
+  WorldIndex(Graph &graph, int num_worlds, uint64_t seed);
+
+  int NumWorlds() const { return num_batches_ * NUM_LANES; }
+  int NumNodes() const { return names_.size(); }
+  int NumArcs() const { return arcs_.size(); }
+
+  // Estimates the probability that one of targets is reached from one of
+  // sources, from the fraction of the worlds where it is. estimate gets one
+  // 0 / 1 value per world. Unknown names are ignored.
+  double Query(const vector<string> &sources, const vector<string> &targets,
+               Accumulator &estimate);
+
+  // A text header (names, arcs and sizes) followed by the raw words.
+  void Write(ostream &out) const;
+  bool Read(istream &in);
+
+private:
+  struct Arc {
+    int source;
+    int target;
+  };
+
+  // Node names by index, and the other way round.
+  vector<string> names_;
+  unordered_map<string, int> indices_;
+
+  vector<Arc> arcs_;
+
+
+  int num_batches_ = 0;
+  uint64_t seed_ = 0;
+
+  // Word of arc a in batch b at b * arcs_.size() + a: bit i is set when
+  // the arc is present in world b * NUM_LANES + i.
+  vector<Lanes> words_;
+
+  // Over the arcs by index.
+  LaneBfs bfs_;
+
+  void BuildOutArcs();
+
+  // Indices of the known names.
+  vector<int> Lookup(const vector<string> &names);
+};
+
+#endif